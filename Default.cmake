@@ -7,10 +7,23 @@ find_path(LIBEV_INCLUDE_DIR ev.h PATH_SUFFIXES include/ev)
 set(CMAKE_CXX_FLAGS "${CMAKE_CXX_FLAGS} -g -std=c++11")
 include_directories(${CMAKE_HOME_DIRECTORY}/include)
 
+find_package(Threads REQUIRED)
+
 include(CheckIncludeFile)
 check_include_file("unistd.h" UNISTD_H)
 if("${UNISTD_H}" STREQUAL "")
     message(WARNING "unistd.h Not found; class EventBuffer being abstract" )
 else()
     set(CMAKE_CXX_FLAGS "${CMAKE_CXX_FLAGS} -DHAVE_UNISTD_H")
+endif()
+
+check_include_file("sys/epoll.h" EPOLL_H)
+if(NOT "${EPOLL_H}" STREQUAL "")
+    set(CMAKE_CXX_FLAGS "${CMAKE_CXX_FLAGS} -DHAVE_EPOLL_H")
+endif()
+
+include(CheckSymbolExists)
+check_symbol_exists(IORING_RECV_MULTISHOT "linux/io_uring.h" IO_URING_H)
+if(IO_URING_H)
+    set(CMAKE_CXX_FLAGS "${CMAKE_CXX_FLAGS} -DHAVE_IO_URING_H")
 endif()
\ No newline at end of file
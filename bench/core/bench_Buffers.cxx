@@ -0,0 +1,70 @@
+#include <chrono>
+#include <cstdio>
+#include <squall/core/Buffers.hxx>
+
+using squall::core::Event;
+using squall::core::IncomingBuffer;
+using squall::core::OutcomingBuffer;
+
+const size_t BLOCK_SIZE = 8 * 1024;
+const size_t MAX_SIZE = 1024 * 1024 + BLOCK_SIZE;
+const size_t TOTAL_BYTES = 1024 * 1024 * 1024;
+
+
+class OutcomingBench : public OutcomingBuffer {
+  public:
+    OutcomingBench()
+        : OutcomingBuffer([](const char* buff, size_t size) { return std::make_pair(size, 0); },
+                          [](bool) { return true; }, BLOCK_SIZE, MAX_SIZE) {}
+
+    using OutcomingBuffer::operator();
+};
+
+
+class IncomingBench : public IncomingBuffer {
+  public:
+    IncomingBench()
+        : IncomingBuffer([](char* buff, size_t size) { return std::make_pair(size, 0); },
+                         [](bool) { return true; }, BLOCK_SIZE, MAX_SIZE) {}
+
+    using IncomingBuffer::operator();
+};
+
+
+/* Transmits 8 KiB blocks while keeping `backlog` bytes queued; returns ns per byte. */
+double benchOutcoming(size_t backlog) {
+    OutcomingBench out;
+    std::vector<char> block(BLOCK_SIZE, 'x');
+    while (out.size() < backlog + BLOCK_SIZE)
+        out.write(block);
+    auto started = std::chrono::steady_clock::now();
+    for (size_t done = 0; done < TOTAL_BYTES; done += BLOCK_SIZE) {
+        out(Event::WRITE);
+        out.write(block);
+    }
+    std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - started;
+    return elapsed.count() / TOTAL_BYTES;
+}
+
+
+/* Reads 8 KiB blocks while keeping `backlog` bytes received; returns ns per byte. */
+double benchIncoming(size_t backlog) {
+    IncomingBench in;
+    while (in.size() < backlog)
+        in(Event::READ);
+    auto started = std::chrono::steady_clock::now();
+    for (size_t done = 0; done < TOTAL_BYTES; done += BLOCK_SIZE) {
+        in(Event::READ);
+        in.read(BLOCK_SIZE);
+    }
+    std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - started;
+    return elapsed.count() / TOTAL_BYTES;
+}
+
+
+int main(int argc, char const* argv[]) {
+    std::printf("%12s %18s %18s\n", "backlog", "outcoming ns/B", "incoming ns/B");
+    for (size_t backlog = BLOCK_SIZE; backlog <= MAX_SIZE - BLOCK_SIZE; backlog *= 2)
+        std::printf("%12zu %18.4f %18.4f\n", backlog, benchOutcoming(backlog), benchIncoming(backlog));
+    return 0;
+}
@@ -0,0 +1,63 @@
+#include <chrono>
+#include <cstdio>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <squall/core/PlatformLoop.hxx>
+#include <squall/core/PlatformWatchers.hxx>
+
+using squall::core::Event;
+using squall::core::IoWatcher;
+using squall::core::PlatformLoop;
+
+const size_t TOTAL = size_t(256) << 20;
+const size_t MESSAGE = 256;
+
+
+/* Receives `TOTAL` bytes written by another thread in `MESSAGE` pieces; prints throughput and wakeups. */
+void benchBulk(const char* name, double io_collect_interval) {
+    int fds[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0)
+        return;
+    fcntl(fds[0], F_SETFL, fcntl(fds[0], F_GETFL) | O_NONBLOCK);
+
+    PlatformLoop::Options options;
+    options.io_collect_interval = io_collect_interval;
+    auto sp_loop = PlatformLoop::createShared(options);
+    std::vector<char> buff(1 << 16);
+    size_t received = 0, wakeups = 0;
+    IoWatcher watcher([&](int revents, void* payload) {
+        wakeups++;
+        auto size = read(fds[0], buff.data(), buff.size());
+        if (size > 0)
+            received += size_t(size);
+        if (received >= TOTAL)
+            sp_loop->stop();
+    }, sp_loop);
+    watcher.setup(fds[0], int(Event::READ));
+
+    auto started = std::chrono::steady_clock::now();
+    std::thread writer([&fds]() {
+        std::vector<char> message(MESSAGE, 'x');
+        for (size_t sent = 0; sent < TOTAL; sent += MESSAGE)
+            if (write(fds[1], message.data(), message.size()) < 0)
+                return;
+    });
+    sp_loop->start();
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - started;
+    writer.join();
+    std::printf("%20s %12.1f %16.1f\n", name, TOTAL / elapsed.count() / (1 << 20), double(wakeups) / (TOTAL >> 20));
+    close(fds[0]);
+    close(fds[1]);
+}
+
+
+int main(int argc, char const* argv[]) {
+    std::printf("%20s %12s %16s\n", "io collect interval", "MB/s", "wakeups/MB");
+    benchBulk("0", 0);
+    benchBulk("0.1 ms", 0.0001);
+    benchBulk("1 ms", 0.001);
+    return 0;
+}
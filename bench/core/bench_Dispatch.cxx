@@ -0,0 +1,163 @@
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <unistd.h>
+#include <squall/core/Buffers.hxx>
+#include <squall/core/Dispatcher.hxx>
+#include "../../demo/core/EventLoop.hxx"
+
+using squall::core::Dispatcher;
+using squall::core::Event;
+using squall::EventLoop;
+using squall::core::IncomingBuffer;
+using squall::core::OutcomingBuffer;
+using squall::core::PlatformLoop;
+
+const size_t EVENTS = 1000000;
+
+static std::atomic<size_t> allocations(0);
+
+/* Counts allocations; replaces the whole set of operators, so each delete matches its new. */
+static void* allocate(size_t size) {
+    allocations++;
+    if (void* ptr = std::malloc(size ? size : 1))
+        return ptr;
+    throw std::bad_alloc();
+}
+
+static void deallocate(void* ptr) noexcept {
+    std::free(ptr);
+}
+
+void* operator new(size_t size) {
+    return allocate(size);
+}
+
+void* operator new[](size_t size) {
+    return allocate(size);
+}
+
+void operator delete(void* ptr) noexcept {
+    deallocate(ptr);
+}
+
+void operator delete[](void* ptr) noexcept {
+    deallocate(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept {
+    deallocate(ptr);
+}
+
+void operator delete[](void* ptr, size_t) noexcept {
+    deallocate(ptr);
+}
+
+
+class OutcomingBench : public OutcomingBuffer {
+  public:
+    OutcomingBench()
+        : OutcomingBuffer([](const char* buff, size_t size) { return std::make_pair(size, 0); },
+                          [](bool) { return true; }, 8, 64) {}
+
+    using OutcomingBuffer::operator();
+};
+
+
+class IncomingBench : public IncomingBuffer {
+  public:
+    IncomingBench()
+        : IncomingBuffer([](char* buff, size_t size) { return std::make_pair(size, 0); },
+                         [](bool) { return true; }, 8, 64) {}
+
+    using IncomingBuffer::operator();
+};
+
+
+/* Prints allocations and time per event of `events` handled from `started`. */
+void report(const char* name, size_t allocated, std::chrono::steady_clock::time_point started, size_t events) {
+    std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - started;
+    std::printf("%20s %16.4f %12.1f\n", name, double(allocations - allocated) / events, elapsed.count() / events);
+}
+
+
+/* Dispatcher handler which stops loop after `EVENTS` events. */
+struct StopHandler {
+    size_t& events;
+    PlatformLoop* p_loop;
+
+    void operator()(int ctx, int revents, void* payload) {
+        if (++events == EVENTS)
+            p_loop->stop();
+    }
+};
+
+
+/* Dispatches `EVENTS` write events of `fd` through dispatcher with given `Handler`; iteration by iteration if `stepwise`. */
+template <typename Handler>
+void benchDispatcher(const char* name, int fd, bool stepwise = false) {
+    auto sp_loop = PlatformLoop::createShared();
+    size_t events = 0;
+    Dispatcher<int, Handler> disp(StopHandler{events, sp_loop.get()}, sp_loop);
+    disp.setupIoWatching(fd, fd, Event::WRITE);
+    size_t allocated = allocations;
+    auto started = std::chrono::steady_clock::now();
+    if (stepwise)
+        sp_loop->runIterations(EVENTS);
+    else
+        sp_loop->start();
+    report(name, allocated, started, EVENTS);
+}
+
+
+int main(int argc, char const* argv[]) {
+    std::array<char, 64> heavy{}; // capture too big to be stored inline by std::function
+    size_t handled = 0;
+    std::printf("%20s %16s %12s\n", "", "allocs/event", "ns/event");
+
+    OutcomingBench out;
+    out.setup([heavy, &handled](int revents, void* payload) { handled += heavy.size(); }, 8);
+    size_t allocated = allocations;
+    auto started = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < EVENTS; i++) {
+        out.write("01234567", 8);
+        out(Event::WRITE);
+    }
+    report("OutcomingBuffer", allocated, started, EVENTS);
+
+    IncomingBench in;
+    in.setup([heavy, &handled](int revents, void* payload) {
+        handled += heavy.size();
+        static_cast<IncomingBench*>(payload)->consume(8);
+    }, std::vector<char>(), 8);
+    allocated = allocations;
+    started = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < EVENTS; i++)
+        in(Event::READ);
+    report("IncomingBuffer", allocated, started, EVENTS);
+
+    int fds[2];
+    if (pipe(fds) != 0)
+        return 1;
+    benchDispatcher<std::function<void(int, int, void*)>>("Dispatcher/function", fds[1]);
+    benchDispatcher<StopHandler>("Dispatcher/functor", fds[1]);
+    benchDispatcher<StopHandler>("Dispatcher/iterations", fds[1], true);
+
+    EventLoop event_loop;
+    size_t events = 0;
+    event_loop.setupIoWatching([heavy, &events, &event_loop](int revents) noexcept {
+        if (++events == EVENTS)
+            event_loop.stop();
+    }, fds[1], Event::WRITE);
+    allocated = allocations;
+    started = std::chrono::steady_clock::now();
+    event_loop.start();
+    report("EventLoop", allocated, started, EVENTS);
+    event_loop.release();
+    close(fds[0]);
+    close(fds[1]);
+    return handled == 0;
+}
@@ -0,0 +1,169 @@
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <squall/core/EpollLoop.hxx>
+#include <squall/core/UringLoop.hxx>
+#include <squall/core/PlatformLoop.hxx>
+#include <squall/core/PlatformWatchers.hxx>
+
+using squall::core::Event;
+using squall::core::IoWatcher;
+using squall::core::PlatformLoop;
+
+const size_t CONNECTIONS = 100;
+const size_t ROUNDS = 200000;
+const size_t MESSAGE = 64;
+
+
+bool watch(IoWatcher& watcher, int fd, bool edge) {
+    return watcher.setup(fd, int(Event::READ));
+}
+
+#ifdef HAVE_EPOLL_H
+using squall::core::EpollLoop;
+using squall::core::EpollWatcher;
+
+bool watch(EpollWatcher& watcher, int fd, bool edge) {
+    return watcher.setup(fd, Event::READ, edge);
+}
+#endif
+
+
+/* Reads all available data of `fd` to `buff`; returns its size. */
+size_t drain(int fd, std::vector<char>& buff) {
+    size_t total = 0;
+    while (true) {
+        auto size = read(fd, buff.data() + total, buff.size() - total);
+        if (size <= 0)
+            return total;
+        total += size_t(size);
+        if (total == buff.size())
+            buff.resize(buff.size() * 2);
+    }
+}
+
+
+/*
+ * Echoes `MESSAGE` bytes over `CONNECTIONS` socket pairs until `ROUNDS`
+ * round trips are done; both sides are watched by one loop.
+ */
+template <typename Loop, typename Watcher>
+void benchEcho(const char* name, const std::shared_ptr<Loop>& sp_loop, bool edge) {
+    std::vector<int> fds;
+    std::vector<std::unique_ptr<Watcher>> watchers;
+    std::vector<char> buff(4096), message(MESSAGE, 'x');
+    size_t rounds = 0;
+
+    for (size_t i = 0; i < CONNECTIONS; i++) {
+        int pair[2];
+        if (socketpair(AF_UNIX, SOCK_STREAM, 0, pair) != 0)
+            return;
+        for (auto fd : pair) {
+            fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+            fds.push_back(fd);
+        }
+        int server = pair[0], client = pair[1];
+        watchers.emplace_back(new Watcher([server, &buff](int revents, void* payload) {
+            auto size = drain(server, buff);
+            if (size > 0 && write(server, buff.data(), size) < 0)
+                std::perror("write");
+        }, sp_loop));
+        watch(*watchers.back(), server, edge);
+        watchers.emplace_back(new Watcher([client, &buff, &message, &rounds, &sp_loop](int revents, void* payload) {
+            if (drain(client, buff) == 0)
+                return;
+            if (++rounds >= ROUNDS)
+                sp_loop->stop();
+            else if (write(client, message.data(), message.size()) < 0)
+                std::perror("write");
+        }, sp_loop));
+        watch(*watchers.back(), client, edge);
+    }
+
+    auto started = std::chrono::steady_clock::now();
+    for (size_t i = 1; i < fds.size(); i += 2)
+        if (write(fds[i], message.data(), message.size()) < 0)
+            std::perror("write");
+    sp_loop->start();
+    std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - started;
+    std::printf("%20s %12.1f\n", name, elapsed.count() / rounds);
+
+    watchers.clear();
+    for (auto fd : fds)
+        close(fd);
+}
+
+
+#ifdef HAVE_IO_URING_H
+using squall::core::UringLoop;
+using squall::core::UringStream;
+
+/* Does the same as `benchEcho` with completion-based streams; prints syscalls per round too. */
+void benchUringEcho(const char* name) {
+    auto sp_loop = UringLoop::createShared();
+    std::vector<int> fds;
+    std::vector<std::unique_ptr<UringStream>> streams;
+    std::vector<char> message(MESSAGE, 'x');
+    size_t rounds = 0;
+
+    for (size_t i = 0; i < CONNECTIONS; i++) {
+        int pair[2];
+        if (socketpair(AF_UNIX, SOCK_STREAM, 0, pair) != 0)
+            return;
+        fds.push_back(pair[0]);
+        fds.push_back(pair[1]);
+        auto p_server = new UringStream([&streams, i](int revents, void* payload) {
+            if (revents == Event::READ) {
+                auto p_chunk = static_cast<UringLoop::Chunk*>(payload);
+                streams[2 * i]->write(p_chunk->data, p_chunk->size);
+            }
+        }, sp_loop);
+        streams.emplace_back(p_server);
+        p_server->setup(pair[0]);
+        auto p_client = new UringStream([&streams, &message, &rounds, &sp_loop, i](int revents, void* payload) {
+            if (revents != Event::READ)
+                return;
+            if (++rounds >= ROUNDS)
+                sp_loop->stop();
+            else
+                streams[2 * i + 1]->write(message.data(), message.size());
+        }, sp_loop);
+        streams.emplace_back(p_client);
+        p_client->setup(pair[1]);
+    }
+
+    auto enters = sp_loop->enters();
+    auto started = std::chrono::steady_clock::now();
+    for (size_t i = 1; i < streams.size(); i += 2)
+        streams[i]->write(message.data(), message.size());
+    sp_loop->start();
+    std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - started;
+    std::printf("%20s %12.1f %16.3f\n", name, elapsed.count() / rounds, double(sp_loop->enters() - enters) / rounds);
+
+    streams.clear();
+    for (auto fd : fds)
+        close(fd);
+}
+#endif
+
+
+int main(int argc, char const* argv[]) {
+    std::printf("%20s %12s %16s\n", "", "ns/round", "enters/round");
+    benchEcho<PlatformLoop, IoWatcher>("libev", PlatformLoop::createShared(), false);
+#ifdef HAVE_EPOLL_H
+    benchEcho<EpollLoop, EpollWatcher>("epoll/level", EpollLoop::createShared(), false);
+    benchEcho<EpollLoop, EpollWatcher>("epoll/edge", EpollLoop::createShared(), true);
+    benchEcho<EpollLoop, EpollWatcher>("epoll/edge/batch 8", EpollLoop::createShared(8), true);
+#endif
+#ifdef HAVE_IO_URING_H
+    if (UringLoop::supported())
+        benchUringEcho("io_uring");
+    else
+        std::printf("%20s %12s\n", "io_uring", "unsupported");
+#endif
+    return 0;
+}
@@ -0,0 +1,65 @@
+#include <chrono>
+#include <cstdio>
+#include <squall/core/Dispatcher.hxx>
+#include <squall/core/Offload.hxx>
+
+using squall::core::Dispatcher;
+using squall::core::Event;
+using squall::core::Offload;
+using squall::core::PlatformLoop;
+using squall::core::ThreadPool;
+
+using Clock = std::chrono::steady_clock;
+
+const double TICK = 0.001;
+const double JOB_EVERY = 0.05;
+const size_t JOBS = 20;
+
+
+/* CPU-heavy work of about 20 ms. */
+void work() {
+    auto until = Clock::now() + std::chrono::milliseconds(20);
+    volatile unsigned long sink = 0;
+    while (Clock::now() < until)
+        for (int i = 0; i < 1000; i++)
+            sink += i;
+}
+
+
+/* Returns the max delay in ms of 1 ms ticks while `JOBS` jobs run inline or offloaded. */
+double bench(bool offloaded) {
+    auto sp_loop = PlatformLoop::createShared();
+    auto sp_pool = ThreadPool::createShared();
+    Offload<int> offload([](int ctx, int revents, void* payload) {}, sp_loop, sp_pool);
+    size_t jobs = 0;
+    double max_delay = 0;
+    auto last = Clock::now();
+
+    Dispatcher<char> disp([&](char ctx, int revents, void* payload) {
+        if (revents != Event::TIMEOUT)
+            return;
+        if (ctx == 'T') {
+            auto now = Clock::now();
+            std::chrono::duration<double, std::milli> delay = now - last;
+            max_delay = (delay.count() > max_delay) ? delay.count() : max_delay;
+            last = now;
+        } else if (++jobs > JOBS) {
+            sp_loop->stop();
+        } else if (offloaded) {
+            offload.submit(int(jobs), work);
+        } else
+            work();
+    }, sp_loop);
+    disp.setupTimerWatching('T', TICK);
+    disp.setupTimerWatching('J', JOB_EVERY);
+    sp_loop->start();
+    return max_delay;
+}
+
+
+int main(int argc, char const* argv[]) {
+    std::printf("%12s %16s\n", "", "max tick, ms");
+    std::printf("%12s %16.2f\n", "inline", bench(false));
+    std::printf("%12s %16.2f\n", "offloaded", bench(true));
+    return 0;
+}
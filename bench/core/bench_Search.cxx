@@ -0,0 +1,65 @@
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <squall/core/Search.hxx>
+
+using squall::core::SearchFunc;
+
+const size_t TOTAL_BYTES = 256 * 1024 * 1024;
+
+
+/*
+ * Searches `needle` placed at the end of `size` bytes, where its first byte
+ * also occurs every 61 bytes as a false candidate; returns ns per byte.
+ */
+double bench(SearchFunc search, size_t size, const std::string& needle) {
+    std::vector<char> haystack(size, 'x');
+    for (size_t i = 0; (needle.size() > 1) && (i < size); i += 61)
+        haystack[i] = needle[0];
+    std::copy(needle.begin(), needle.end(), haystack.end() - needle.size());
+    auto begin = haystack.data(), end = begin + size;
+    volatile size_t found = 0;
+    auto started = std::chrono::steady_clock::now();
+    for (size_t done = 0; done < TOTAL_BYTES; done += size)
+        found += search(begin, end, needle.data(), needle.size()) - begin;
+    std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - started;
+    return elapsed.count() / TOTAL_BYTES;
+}
+
+
+/* Search with std::search for comparison. */
+const char* searchStd(const char* begin, const char* end, const char* needle, size_t length) {
+    return std::search(begin, end, needle, needle + length);
+}
+
+
+int main(int argc, char const* argv[]) {
+    std::vector<std::pair<const char*, SearchFunc>> functions = {
+        {"std", searchStd}, {"scalar", squall::core::searchScalar}, {"dispatch", squall::core::searchBytes}};
+#if defined(SQUALL_SEARCH_X86) && defined(__SSE2__)
+    functions.push_back({"sse2", squall::core::searchSSE2});
+#endif
+#if defined(SQUALL_SEARCH_X86)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+        functions.push_back({"avx2", squall::core::searchAVX2});
+#endif
+    std::vector<std::pair<const char*, std::string>> needles = {
+        {"LF", "\n"}, {"CRLF", "\r\n"}, {"CRLFCRLF", "\r\n\r\n"}};
+
+    for (auto const& needle : needles) {
+        std::printf("%s, ns/B\n%10s", needle.first, "size");
+        for (auto const& function : functions)
+            std::printf(" %10s", function.first);
+        std::printf("\n");
+        for (size_t size = 64; size <= 1024 * 1024; size *= 4) {
+            std::printf("%10zu", size);
+            for (auto const& function : functions)
+                std::printf(" %10.4f", bench(function.second, size, needle.second));
+            std::printf("\n");
+        }
+    }
+    return 0;
+}
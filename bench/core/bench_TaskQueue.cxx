@@ -0,0 +1,41 @@
+#include <chrono>
+#include <cstdio>
+#include <thread>
+#include <vector>
+#include <squall/core/TaskQueue.hxx>
+
+using squall::core::PlatformLoop;
+using squall::core::TaskQueue;
+
+const size_t TASKS = 1000000;
+
+
+/* Posts `TASKS` tasks from `producers` threads to running loop. */
+void bench(int producers) {
+    auto sp_loop = PlatformLoop::createShared();
+    auto sp_queue = TaskQueue::createShared(sp_loop);
+    size_t done = 0;
+    auto started = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (int p = 0; p < producers; p++)
+        threads.emplace_back([&]() {
+            for (size_t i = 0; i < TASKS / producers; i++)
+                sp_queue->post([&]() {
+                    if (++done == (TASKS / producers) * producers)
+                        sp_loop->stop();
+                });
+        });
+    sp_loop->start();
+    for (auto& thread : threads)
+        thread.join();
+    std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - started;
+    std::printf("%10d %14.1f %18.6f\n", producers, elapsed.count() / done, double(sp_queue->wakeups()) / done);
+}
+
+
+int main(int argc, char const* argv[]) {
+    std::printf("%10s %14s %18s\n", "producers", "ns/task", "wakeups/task");
+    for (int producers = 1; producers <= 4; producers *= 2)
+        bench(producers);
+    return 0;
+}
@@ -0,0 +1,50 @@
+#include <chrono>
+#include <cstdio>
+#include <vector>
+#include <squall/core/Dispatcher.hxx>
+
+using squall::core::FdDispatcher;
+using squall::core::PlatformLoop;
+
+const int CONNECTIONS = 200000;
+const size_t ROUNDS = 10;
+
+
+/* Dispatcher handler doing nothing; timeouts are never expired here. */
+struct NoopHandler {
+    void operator()(int ctx, int revents, void* payload) {}
+};
+
+
+/* Returns ns per re-arm of `CONNECTIONS` timeouts reset in scattered order by `rearm`. */
+template <typename Rearm>
+double bench(Rearm rearm) {
+    std::vector<int> order;
+    for (int i = 0; i < CONNECTIONS; i++)
+        order.push_back((i * 7919) % CONNECTIONS);
+    for (auto ctx : order)
+        rearm(ctx, 30.0 + ctx % 100);
+    auto started = std::chrono::steady_clock::now();
+    for (size_t round = 0; round < ROUNDS; round++)
+        for (auto ctx : order)
+            rearm(ctx, 30.0 + (ctx + round) % 100);
+    std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - started;
+    return elapsed.count() / (ROUNDS * CONNECTIONS);
+}
+
+
+int main(int argc, char const* argv[]) {
+    auto sp_loop = PlatformLoop::createShared();
+    FdDispatcher<NoopHandler> disp(NoopHandler(), sp_loop);
+
+    std::printf("%20s %12s\n", "", "ns/re-arm");
+    std::printf("%20s %12.1f\n", "libev timers",
+                bench([&disp](int ctx, double seconds) { disp.setupTimerWatching(ctx, seconds); }));
+    std::printf("%20s %12.1f\n", "timing wheel",
+                bench([&disp](int ctx, double seconds) { disp.setupTimeoutWatching(ctx, seconds); }));
+    for (int ctx = 0; ctx < CONNECTIONS; ctx++)
+        disp.setupActivityWatching(ctx, 30.0);
+    std::printf("%20s %12.1f\n", "activity touch",
+                bench([&disp](int ctx, double seconds) { disp.touchActivityWatching(ctx); }));
+    return 0;
+}
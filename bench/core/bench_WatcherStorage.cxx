@@ -0,0 +1,79 @@
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <vector>
+#include <squall/core/WatcherStorage.hxx>
+
+using squall::core::ArenaStorage;
+using squall::core::FdStorage;
+using squall::core::HashStorage;
+
+const int CONTEXTS = 100000;
+const size_t ROUNDS = 10;
+
+static std::atomic<size_t> allocations(0);
+
+void* operator new(size_t size) {
+    allocations++;
+    if (void* ptr = std::malloc(size ? size : 1))
+        return ptr;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept {
+    std::free(ptr);
+}
+
+
+/* Stored value of libev I/O watcher size. */
+struct Value {
+    char data[64];
+    Value(int ctx) {
+        data[0] = char(ctx);
+    }
+};
+
+
+/* Measures lookups and setup/cancel churn over `CONTEXTS` stored values. */
+template <template <typename, typename> class Storage>
+void bench(const char* name) {
+    Storage<int, Value> storage;
+    std::vector<int> order;
+    for (int i = 0; i < CONTEXTS; i++) {
+        storage.emplace(i, i);
+        order.push_back((i * 7919) % CONTEXTS); // scattered access
+    }
+
+    size_t found = 0;
+    auto started = std::chrono::steady_clock::now();
+    for (size_t round = 0; round < ROUNDS; round++)
+        for (auto ctx : order)
+            found += (storage.find(ctx) != nullptr);
+    std::chrono::duration<double, std::nano> lookup = std::chrono::steady_clock::now() - started;
+
+    size_t allocated = allocations;
+    started = std::chrono::steady_clock::now();
+    for (size_t round = 0; round < ROUNDS; round++)
+        for (auto ctx : order) {
+            storage.erase(ctx);
+            storage.emplace(ctx, ctx);
+        }
+    std::chrono::duration<double, std::nano> churn = std::chrono::steady_clock::now() - started;
+
+    size_t ops = ROUNDS * CONTEXTS;
+    std::printf("%12s %14.1f %14.1f %14.4f\n", name, lookup.count() / ops, churn.count() / ops,
+                double(allocations - allocated) / ops);
+    if (found != ops)
+        std::abort();
+}
+
+
+int main(int argc, char const* argv[]) {
+    std::printf("%12s %14s %14s %14s\n", "", "lookup ns", "churn ns", "churn allocs");
+    bench<HashStorage>("HashStorage");
+    bench<ArenaStorage>("ArenaStorage");
+    bench<FdStorage>("FdStorage");
+    return 0;
+}
@@ -116,17 +116,28 @@ class EventLoop : core::NonCopyable {
     }
 
     /**
-     * Setup to call `callback` after `seconds`
+     * Setup to call `callback` once after `seconds`
+     * rounded up to timeout resolution of dispatcher.
      */
     Handle setupTimeoutWatching(Callback&& callback, double seconds) {
-        auto wrapped = Callback(std::forward<Callback>(callback));
-        Handle handle = setupTimerWatching(
-            [this, &handle, wrapped](int revents) {
-                this->cancelTimerWatching(handle);
-                wrapped(revents);
-            },
-            seconds);
-        return handle;
+        if (active()) {
+            auto handle = std::shared_ptr<Callback>(new Callback(std::forward<Callback>(callback)));
+            dispatcher.setupTimeoutWatching(handle, seconds);
+            return handle;
+        }
+        throw exc::CannotSetupWatching();
+    }
+
+    /**
+     * Re-arms a timeout established with method `setupTimeoutWatching`
+     * for a given `handle` to be called after `seconds` from now.
+     */
+    bool resetTimeoutWatching(Handle& handle, double seconds) {
+        if (active()) {
+            dispatcher.setupTimeoutWatching(handle, seconds);
+            return true;
+        }
+        return false;
     }
 
     /**
@@ -134,7 +145,42 @@ class EventLoop : core::NonCopyable {
      * with method `setupTimeoutWatching` for a given `handle`.
      */
     bool cancelTimeoutWatching(Handle& handle) {
-        return dispatcher.cancelTimerWatching(handle);
+        if (active())
+            return dispatcher.cancelTimeoutWatching(handle);
+        return false;
+    }
+
+    /**
+     * Setup to call `callback` when `touchActivityWatching`
+     * was not called for a given `handle` for `seconds`.
+     */
+    Handle setupActivityWatching(Callback&& callback, double seconds) {
+        if (active()) {
+            auto handle = std::shared_ptr<Callback>(new Callback(std::forward<Callback>(callback)));
+            dispatcher.setupActivityWatching(handle, seconds);
+            return handle;
+        }
+        throw exc::CannotSetupWatching();
+    }
+
+    /**
+     * Marks activity for event watchig established
+     * with method `setupActivityWatching` for a given `handle`.
+     */
+    bool touchActivityWatching(Handle& handle) noexcept {
+        if (active())
+            return dispatcher.touchActivityWatching(handle);
+        return false;
+    }
+
+    /**
+     * Cancels an event watchig established
+     * with method `setupActivityWatching` for a given `handle`.
+     */
+    bool cancelActivityWatching(Handle& handle) {
+        if (active())
+            return dispatcher.cancelActivityWatching(handle);
+        return false;
     }
 
     /**
@@ -166,8 +212,8 @@ class EventLoop : core::NonCopyable {
     core::Dispatcher<std::shared_ptr<Callback>> dispatcher;
 
     void on_event(std::shared_ptr<Callback> handle, int revents) {
-        auto callback = *handle.get();
-        callback(revents);
+        // `handle` copy keeps callback alive even if it cancels itself
+        (*handle)(revents);
     }
 };
 }
@@ -0,0 +1,75 @@
+#include <cstdlib>
+#include <csignal>
+#include <iostream>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <squall/core/Dispatcher.hxx>
+#include <squall/core/LoopGroup.hxx>
+#include <squall/core/Sockets.hxx>
+
+using squall::core::Event;
+using squall::core::FdDispatcher;
+using squall::core::LoopGroup;
+using squall::core::PlatformLoop;
+
+
+/* Echo server of one loop; it shares nothing with servers of other loops. */
+class EchoServer {
+  public:
+    EchoServer(const std::shared_ptr<PlatformLoop>& sp_loop, unsigned short port)
+        : listener(squall::core::listenSocket("", port)),
+          disp([this](int fd, int revents, void* payload) { onEvent(fd, revents); }, sp_loop) {
+        disp.setupIoWatching(listener, listener, Event::READ);
+    }
+
+    ~EchoServer() {
+        disp.release();
+        close(listener);
+    }
+
+  private:
+    int listener;
+    FdDispatcher<> disp;
+
+    void onEvent(int fd, int revents) {
+        if (revents == Event::CLEANUP) {
+            if (fd != listener)
+                close(fd);
+        } else if (fd == listener) {
+            int client;
+            while ((client = accept4(listener, nullptr, nullptr, SOCK_NONBLOCK)) >= 0)
+                disp.setupIoWatching(client, client, Event::READ);
+        } else {
+            char buff[4096];
+            auto received = read(fd, buff, sizeof(buff));
+            if ((received <= 0) || (write(fd, buff, received) != received)) {
+                disp.cancelIoWatching(fd);
+                close(fd);
+            }
+        }
+    }
+};
+
+
+int main(int argc, char const* argv[]) {
+    unsigned short port = (argc > 1) ? std::atoi(argv[1]) : 9000;
+    auto sp_group = LoopGroup::createShared();
+
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    pthread_sigmask(SIG_BLOCK, &signals, nullptr); // loop threads inherit the mask
+
+    sp_group->start([port](size_t index, const std::shared_ptr<PlatformLoop>& sp_loop) {
+        return std::make_shared<EchoServer>(sp_loop, port);
+    });
+    std::cout << "Echo on port " << port << " with " << sp_group->size() << " loops; press Ctrl+C to stop."
+              << std::endl;
+
+    int signum;
+    sigwait(&signals, &signum);
+    sp_group->stop();
+    sp_group->join();
+    std::cout << "\nBye!" << std::endl;
+    return 0;
+}
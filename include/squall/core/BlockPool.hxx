@@ -0,0 +1,115 @@
+#ifndef SQUALL__CORE__BLOCK_POOL_HXX
+#define SQUALL__CORE__BLOCK_POOL_HXX
+#include <memory>
+#include <vector>
+#include "NonCopyable.hxx"
+
+namespace squall {
+namespace core {
+
+
+/*
+ * Pool of fixed-size memory blocks shared by buffers of one loop.
+ * Buffers borrow blocks on demand and give them back when drained,
+ * so idle buffers hold no memory. Pool is not thread safe.
+ */
+class BlockPool : NonCopyable {
+  public:
+    /* Pool statistics */
+    struct Stats {
+        size_t borrowed = 0;    // blocks in use by buffers
+        size_t cached = 0;      // idle blocks kept by pool
+        size_t allocations = 0; // blocks allocated from heap
+        size_t misses = 0;      // refused borrowings because of limit
+    };
+
+    /* Returns created pointer to new pool. */
+    static std::shared_ptr<BlockPool> createShared(size_t block_size = 8192, size_t max_cached = 1024,
+                                                   size_t max_borrowed = 0) {
+        return std::shared_ptr<BlockPool>(new BlockPool(block_size, max_cached, max_borrowed));
+    }
+
+    /* Destructor */
+    ~BlockPool() {
+        shrink();
+    }
+
+    /* Returns size of block. */
+    size_t blockSize() const noexcept {
+        return block_size;
+    }
+
+    /* Returns pool statistics. */
+    const Stats& stats() const noexcept {
+        return stats_;
+    }
+
+    /* Sets max number of idle blocks kept by pool. */
+    void setMaxCached(size_t number) {
+        max_cached = number;
+        cached.reserve(max_cached);
+        while (cached.size() > max_cached)
+            dropCached();
+    }
+
+    /* Sets max number of blocks in use by buffers; zero means no limit. */
+    void setMaxBorrowed(size_t number) noexcept {
+        max_borrowed = number;
+    }
+
+    /* Returns block or nullptr if the limit of borrowed blocks is reached. */
+    char* borrow() {
+        if (max_borrowed && (stats_.borrowed >= max_borrowed)) {
+            stats_.misses++;
+            return nullptr;
+        }
+        char* block;
+        if (!cached.empty()) {
+            block = cached.back();
+            cached.pop_back();
+            stats_.cached--;
+        } else {
+            block = new char[block_size];
+            stats_.allocations++;
+        }
+        stats_.borrowed++;
+        return block;
+    }
+
+    /* Gives back borrowed block. */
+    void giveBack(char* block) {
+        stats_.borrowed--;
+        if (cached.size() < max_cached) {
+            cached.push_back(block);
+            stats_.cached++;
+        } else
+            delete[] block;
+    }
+
+    /* Frees all idle blocks. */
+    void shrink() {
+        while (!cached.empty())
+            dropCached();
+    }
+
+  private:
+    std::vector<char*> cached;
+    size_t block_size, max_cached, max_borrowed;
+    Stats stats_;
+
+    /* Constructor */
+    BlockPool(size_t block_size, size_t max_cached, size_t max_borrowed)
+        : block_size(block_size), max_cached(max_cached), max_borrowed(max_borrowed) {
+        cached.reserve(max_cached);
+    }
+
+    /* Frees the last cached block. */
+    void dropCached() {
+        delete[] cached.back();
+        cached.pop_back();
+        stats_.cached--;
+    }
+};
+} // squall::core
+} // squall
+#endif // SQUALL__CORE__BLOCK_POOL_HXX
@@ -0,0 +1,164 @@
+#ifndef SQUALL__CORE__BUFFER_STORAGE_HXX
+#define SQUALL__CORE__BUFFER_STORAGE_HXX
+#include <memory>
+#include <cstring>
+#include "BlockPool.hxx"
+#include "NonCopyable.hxx"
+
+namespace squall {
+namespace core {
+
+
+/*
+ * Contiguous byte storage for event-driven buffers.
+ * Data lives between `head` and `tail` offsets, so a consume from
+ * the front is O(1); the free space before `head` is reclaimed lazily,
+ * only when the moved bytes are not more than the consumed ones.
+ * Storage with block pool takes memory from the pool when it fits
+ * into a block, and releases memory as soon as it is drained, including
+ * by an empty `commit` of nothing received, so idle storage holds no block.
+ */
+class BufferStorage : NonCopyable {
+  public:
+    /* Constructor */
+    BufferStorage() {}
+
+    /* Destructor */
+    ~BufferStorage() {
+        release();
+    }
+
+    /* Returns number of stored bytes. */
+    size_t size() const noexcept {
+        return tail - head;
+    }
+
+    /* Returns true if storage has no data. */
+    bool empty() const noexcept {
+        return tail == head;
+    }
+
+    /* Returns size of allocated memory. */
+    size_t capacity() const noexcept {
+        return cap;
+    }
+
+    /* Returns number of bytes writable after stored data without reallocation. */
+    size_t spare() const noexcept {
+        return cap - tail;
+    }
+
+    /* Returns pointer to the first stored byte. */
+    const char* data() const noexcept {
+        return mem + head;
+    }
+
+    /* Returns pointer to the first stored byte. */
+    char* data() noexcept {
+        return mem + head;
+    }
+
+    /* Returns block pool used by storage. */
+    const std::shared_ptr<BlockPool>& blockPool() const noexcept {
+        return sp_pool;
+    }
+
+    /* Sets block pool for next allocations; empty storage releases its memory at once. */
+    void setBlockPool(const std::shared_ptr<BlockPool>& sp_pool) {
+        this->sp_pool = sp_pool;
+        if (empty())
+            release();
+    }
+
+    /* Returns pointer to at least `number` writable bytes after stored data. */
+    char* prepare(size_t number) {
+        if (cap - tail < number) {
+            auto stored = size();
+            if ((head >= stored) && (stored + number <= cap)) {
+                // cheap compaction; moves not more than was consumed
+                if (stored > 0)
+                    std::memmove(mem, mem + head, stored);
+            } else {
+                auto new_cap = (cap > 0) ? cap * 2 : number;
+                while (new_cap < stored + number)
+                    new_cap *= 2;
+                std::shared_ptr<BlockPool> new_mem_pool;
+                char* new_mem = nullptr;
+                if (sp_pool && (stored + number <= sp_pool->blockSize())) {
+                    new_mem = sp_pool->borrow();
+                    if (new_mem != nullptr) {
+                        new_cap = sp_pool->blockSize();
+                        new_mem_pool = sp_pool;
+                    }
+                }
+                if (new_mem == nullptr)
+                    new_mem = new char[new_cap];
+                if (stored > 0)
+                    std::memcpy(new_mem, mem + head, stored);
+                release();
+                mem = new_mem;
+                mem_pool.swap(new_mem_pool);
+                cap = new_cap;
+            }
+            head = 0;
+            tail = stored;
+        }
+        return mem + tail;
+    }
+
+    /* Appends to stored data `number` bytes written to space given by `prepare`. */
+    void commit(size_t number) noexcept {
+        tail += number;
+        if (empty())
+            drained(); // nothing received; pooled block goes back to cached ones
+    }
+
+    /* Appends `number` bytes from `source` to stored data. */
+    void append(const char* source, size_t number) {
+        if (number > 0) {
+            std::memcpy(prepare(number), source, number);
+            commit(number);
+        }
+    }
+
+    /* Drops `number` bytes from the front of stored data. */
+    void consume(size_t number) noexcept {
+        head += number;
+        if (head >= tail)
+            drained();
+    }
+
+    /* Drops all stored data. */
+    void clear() noexcept {
+        drained();
+    }
+
+    /* Drops all stored data and frees memory. */
+    void release() noexcept {
+        if (mem != nullptr) {
+            if (mem_pool)
+                mem_pool->giveBack(mem);
+            else
+                delete[] mem;
+            mem_pool.reset();
+            mem = nullptr;
+        }
+        cap = head = tail = 0;
+    }
+
+  private:
+    std::shared_ptr<BlockPool> sp_pool, mem_pool;
+    char* mem = nullptr;
+    size_t cap = 0, head = 0, tail = 0;
+
+    /* Resets offsets of drained storage; pooled one releases memory. */
+    void drained() noexcept {
+        if (sp_pool)
+            release();
+        else
+            head = tail = 0;
+    }
+};
+} // squall::core
+} // squall
+#endif // SQUALL__CORE__BUFFER_STORAGE_HXX
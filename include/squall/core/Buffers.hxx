@@ -1,10 +1,21 @@
 #ifndef SQUALL__CORE__BUFFERS_HXX
 #define SQUALL__CORE__BUFFERS_HXX
+#include <string>
 #include <vector>
 #include <algorithm>
 #include <functional>
+#include <deque>
+#include <memory>
+#include <initializer_list>
+#include <cerrno>
 #include <cassert>
+#ifdef HAVE_UNISTD_H
+#include <climits>
+#include <sys/uio.h>
+#endif
 #include "Exceptions.hxx"
+#include "BufferStorage.hxx"
+#include "Search.hxx"
 #include "NonCopyable.hxx"
 #include "PlatformLoop.hxx"
 
@@ -12,6 +23,92 @@ namespace squall {
 namespace core {
 
 
+/*
+ * Event handler holder; handler is called without copying and may replace,
+ * reset or destroy its holder from inside its own call. Handler being called
+ * is moved out to the call frame, which keeps it alive until it returns,
+ * and is moved back only if the holder still exists and was not changed.
+ */
+class EventHandler : NonCopyable {
+  public:
+    /* Constructor */
+    EventHandler(std::nullptr_t = nullptr) noexcept {}
+
+    /* Destructor; calls in progress are detached, so they do not touch this after return. */
+    ~EventHandler() {
+        for (auto p_frame = p_call; p_frame != nullptr; p_frame = p_frame->p_outer)
+            p_frame->p_holder = nullptr;
+    }
+
+    /* Returns true if handler is set. */
+    explicit operator bool() const noexcept {
+        return (p_running != nullptr) || bool(handler);
+    }
+
+    /* Sets handler. */
+    EventHandler& operator=(OnEvent&& handler) {
+        this->handler = std::forward<OnEvent>(handler);
+        p_running = nullptr;
+        return *this;
+    }
+
+    /* Resets handler. */
+    EventHandler& operator=(std::nullptr_t) noexcept {
+        handler = nullptr;
+        p_running = nullptr;
+        return *this;
+    }
+
+    /* Calls handler. */
+    void operator()(int revents, void* payload) {
+        call(false, revents, payload);
+    }
+
+    /* Resets handler and calls it, so it is called being already reset. */
+    void resetAndCall(int revents, void* payload) {
+        call(true, revents, payload);
+    }
+
+  private:
+    /* Call in progress */
+    struct Frame {
+        EventHandler* p_holder;
+        Frame* p_outer;
+        OnEvent handler;
+    };
+
+    OnEvent handler;               // current handler unless it is being called
+    OnEvent* p_running = nullptr;  // current handler while it is being called
+    Frame* p_call = nullptr;       // innermost call in progress
+
+    /* Calls current handler; nested call of the same handler calls it in place of the outer frame. */
+    void call(bool reset, int revents, void* payload) {
+        struct Guard {
+            Frame frame;
+            ~Guard() {
+                auto p_holder = frame.p_holder;
+                if (p_holder != nullptr) {
+                    p_holder->p_call = frame.p_outer;
+                    if (p_holder->p_running == &frame.handler) {
+                        p_holder->handler = std::move(frame.handler);
+                        p_holder->p_running = nullptr;
+                    }
+                }
+            }
+        } guard{{this, p_call, nullptr}};
+        auto p_handler = p_running;
+        if (p_handler == nullptr) {
+            guard.frame.handler = std::move(handler);
+            handler = nullptr;
+            p_handler = &guard.frame.handler;
+        }
+        p_running = reset ? nullptr : p_handler;
+        p_call = &guard.frame;
+        (*p_handler)(revents, payload);
+    }
+};
+
+
 /* Base I/O buffer. */
 class BaseBuffer : NonCopyable {
   public:
@@ -36,6 +133,14 @@ class BaseBuffer : NonCopyable {
     /* Calculated buffer task result */
     virtual intptr_t lastResult() const noexcept = 0;
 
+    /*
+     * Sets block pool shared by buffers of one loop;
+     * buffer memory is borrowed from it and given back when drained.
+     */
+    void setBlockPool(const std::shared_ptr<BlockPool>& sp_pool) {
+        buff.setBlockPool(sp_pool);
+    }
+
     /* Returns last error code */
     int lastError() const noexcept {
         return last_error;
@@ -51,13 +156,13 @@ class BaseBuffer : NonCopyable {
         if (on_event)
             on_event(Event::CLEANUP, (void*)this);
         cancel();
-        buff.clear();
+        clear();
     }
 
   protected:
-    OnEvent on_event;
+    EventHandler on_event;
     FlowCtrl flow_ctrl;
-    std::vector<char> buff;
+    BufferStorage buff;
     size_t block_size, max_size;
     bool paused = true;
     int last_error;
@@ -85,18 +190,26 @@ class BaseBuffer : NonCopyable {
         if (!paused)
             paused = flow_ctrl(false);
     }
+
+    /* Drops buffered data and frees memory. */
+    void clear() noexcept {
+        buff.release();
+    }
 };
 
 
-/* Event-driven outcoming buffer. */
-class OutcomingBuffer : public BaseBuffer {
+/*
+ * Buffer task and event handling shared by outcoming buffers. `Derived` gives
+ * `size()`, `write(const char*, size_t)` and `transmit()`, which sends data
+ * from the front of the buffer and drops sent bytes; they are called without
+ * virtual dispatch.
+ */
+template <typename Derived>
+class BasicOutcomingBuffer : public BaseBuffer {
   public:
-    /* Data transmiter interface */
-    using Transmiter = std::function<std::pair<size_t, int>(const char* buff, size_t block_size)>;
-
     /* Calculated buffer task result */
     intptr_t lastResult() const noexcept {
-        if (on_event && (size() <= threshold))
+        if (on_event && (derived().size() <= threshold))
             return 1;
         return 0;
     }
@@ -116,27 +229,34 @@ class OutcomingBuffer : public BaseBuffer {
     }
 
     /* Writes data to the outcoming buffer. Returns number of written bytes. */
-    size_t write(std::vector<char> data) {
-        auto number = max_size - size();
-        number = (data.size() < number) ? data.size() : number;
-        if (number > 0) {
-            std::copy(data.begin(), data.begin() + number, std::back_inserter(buff));
-            resume();
-            return number;
-        }
-        return 0;
+    size_t write(const std::vector<char>& data) {
+        return derived().write(data.data(), data.size());
+    }
+
+    /* Writes data to the outcoming buffer. Returns number of written bytes. */
+    size_t write(const std::string& data) {
+        return derived().write(data.data(), data.size());
+    }
+
+    /* Writes data to the outcoming buffer; keeps `write({...})` unambiguous. Returns number of written bytes. */
+    size_t write(std::initializer_list<char> data) {
+        return derived().write(data.begin(), data.size());
     }
 
   protected:
-    Transmiter transmiter;
     size_t threshold;
     int mode;
 
     /* Constructor */
-    OutcomingBuffer(Transmiter&& transmiter, FlowCtrl&& flow_ctrl, size_t block_size, size_t max_size)
-        : BaseBuffer(std::forward<FlowCtrl>(flow_ctrl), block_size, max_size),
-          transmiter(std::forward<Transmiter>(transmiter)), threshold(0), mode(Event::WRITE) {
-        resume();
+    BasicOutcomingBuffer(FlowCtrl&& flow_ctrl, size_t block_size, size_t max_size)
+        : BaseBuffer(std::forward<FlowCtrl>(flow_ctrl), block_size, max_size), threshold(0), mode(Event::WRITE) {}
+
+    Derived& derived() noexcept {
+        return *static_cast<Derived*>(this);
+    }
+
+    const Derived& derived() const noexcept {
+        return *static_cast<const Derived*>(this);
     }
 
     void operator()(int revents) {
@@ -144,48 +264,156 @@ class OutcomingBuffer : public BaseBuffer {
             last_error = 0;
             if (revents == mode) {
                 revents = 0;
-                auto number = block_size < size() ? block_size : size();
-                if (number > 0) {
-                    auto transmiter_result = transmiter(&(*buff.begin()), number);
-                    if (transmiter_result.first > 0) {
-                        buff.erase(buff.begin(), buff.begin() + transmiter_result.first);
-                    } else {
+                if (derived().size() > 0) {
+                    auto transmiter_result = derived().transmit();
+                    if (transmiter_result.first == 0) {
                         revents = Event::BUFFER | Event::ERROR;
                         if (transmiter_result.second > 0)
                             last_error = transmiter_result.second;
                     }
                 }
             }
-            if ((revents & Event::ERROR) || (size() == 0))
+            if ((revents & Event::ERROR) || (derived().size() == 0))
                 pause();
             if (on_event) {
-                OnEvent callback = on_event;
                 if (!((revents & Event::ERROR))) {
                     if (lastResult() > 0)
                         revents = Event::BUFFER | Event::WRITE;
+                    if (revents)
+                        on_event(revents, (void*)this);
                 } else
-                    cancel();
-                if (revents)
-                    callback(revents, (void*)this);
+                    on_event.resetAndCall(revents, (void*)this); // cancels buffer task
             }
         }
     }
 };
 
 
+/* Event-driven outcoming buffer. */
+class OutcomingBuffer : public BasicOutcomingBuffer<OutcomingBuffer> {
+    friend class BasicOutcomingBuffer<OutcomingBuffer>;
+
+  public:
+    /* Data transmiter interface */
+    using Transmiter = std::function<std::pair<size_t, int>(const char* buff, size_t block_size)>;
+
+    using BasicOutcomingBuffer<OutcomingBuffer>::write;
+
+    /* Returns true if write-through mode is on. */
+    bool writeThrough() const noexcept {
+        return write_through;
+    }
+
+    /*
+     * Sets write-through mode; in this mode data written to the empty buffer
+     * is passed to the transmiter at once and only the unsent tail is buffered.
+     * Transmiter failure in this case only buffers data; error is reported
+     * by the next event as usual.
+     */
+    void setWriteThrough(bool enable) noexcept {
+        write_through = enable;
+    }
+
+    /* Writes data to the outcoming buffer. Returns number of written bytes. */
+    size_t write(const char* data, size_t number) {
+        auto available = max_size - size();
+        number = (number < available) ? number : available;
+        if (number > 0) {
+            auto sent = (write_through && buff.empty()) ? transmitThrough(data, number) : 0;
+            buff.append(data + sent, number - sent);
+            if ((sent < number) || on_event)
+                resume();
+            return number;
+        }
+        return 0;
+    }
+
+    /*
+     * Returns pointer to and size of space at the end of the outcoming buffer
+     * to write directly how much is there, but not more `number` bytes.
+     * Written bytes are added to the buffer by `commit`.
+     */
+    std::pair<char*, size_t> prepare(size_t number) {
+        auto available = max_size - size();
+        number = (number < available) ? number : available;
+        return std::make_pair(buff.prepare(number), number);
+    }
+
+    /* Adds to the outcoming buffer `number` bytes written to space given by `prepare`. */
+    void commit(size_t number) {
+        if (number > 0) {
+            auto through = write_through && buff.empty();
+            buff.commit(number);
+            if (through)
+                buff.consume(transmitThrough(buff.data(), number));
+            if (!buff.empty() || on_event)
+                resume();
+        }
+    }
+
+  protected:
+    Transmiter transmiter;
+    bool write_through;
+
+    /* Constructor */
+    OutcomingBuffer(Transmiter&& transmiter, FlowCtrl&& flow_ctrl, size_t block_size, size_t max_size)
+        : BasicOutcomingBuffer<OutcomingBuffer>(std::forward<FlowCtrl>(flow_ctrl), block_size, max_size),
+          transmiter(std::forward<Transmiter>(transmiter)), write_through(false) {
+        resume();
+    }
+
+    /* Transmits data bypassing the buffer; returns number of sent bytes. */
+    size_t transmitThrough(const char* data, size_t number) {
+        auto transmiter_result = transmiter(data, number);
+        return (transmiter_result.first < number) ? transmiter_result.first : number;
+    }
+
+    /* Transmits up to `block_size` bytes from the front of the buffer. */
+    std::pair<size_t, int> transmit() {
+        auto number = block_size < size() ? block_size : size();
+        auto transmiter_result = transmiter(buff.data(), number);
+        if (transmiter_result.first > 0)
+            buff.consume(transmiter_result.first);
+        return transmiter_result;
+    }
+};
+
+
 /* Event-driven incoming buffer. */
 class IncomingBuffer : public BaseBuffer {
   public:
     /* Data receiver interface */
     using Receiver = std::function<std::pair<size_t, int>(char* buff, size_t block_size)>;
 
+    /* Budget exhaustion handler */
+    using Renotify = std::function<void()>;
+
+    /* Returns max number of bytes received per one event. */
+    size_t drainBudget() const noexcept {
+        return budget;
+    }
+
+    /*
+     * Sets max number of bytes (zero means `block_size`) and receiver calls
+     * (zero means no limit) per one event. Receiver is called by `block_size`
+     * until it returns less than requested, buffer is full or budget runs out.
+     * In the last case `renotify` is called, because device may have more data;
+     * edge-triggered watching has to feed READ event from it, level-triggered
+     * one does not need it.
+     */
+    void setDrainBudget(size_t bytes, size_t iterations = 0, Renotify&& renotify = nullptr) {
+        budget = (bytes > 0) ? bytes : block_size;
+        this->iterations = iterations;
+        this->renotify = std::forward<Renotify>(renotify);
+    }
+
     /* Calculated buffer task result */
     intptr_t lastResult() const noexcept {
         if (on_event) {
             if (delimiter.size() > 0) {
-                auto found = std::search(buff.begin(), buff.end(), delimiter.begin(), delimiter.end());
-                if (found != buff.end()) {
-                    auto result = std::distance(buff.begin(), found) + delimiter.size();
+                auto found = searchDelimiter();
+                if (found != size()) {
+                    auto result = found + delimiter.size();
                     return (result < threshold) ? result : -1;
                 } else {
                     if (size() >= threshold)
@@ -204,6 +432,7 @@ class IncomingBuffer : public BaseBuffer {
         // setup new buffer task
         this->threshold = threshold;
         this->delimiter = delimiter;
+        this->scanned = 0;
         this->on_event = std::forward<OnEvent>(on_event);
         auto early_result = lastResult();
         if (!early_result)
@@ -213,42 +442,116 @@ class IncomingBuffer : public BaseBuffer {
 
     /* Read bytes from incoming buffer how much is there, but not more `number`. */
     std::vector<char> read(size_t number) {
-        std::vector<char> result;
+        auto view = peek(number);
+        std::vector<char> result(view.first, view.first + view.second);
+        consume(view.second);
+        return result;
+    }
+
+    /*
+     * Returns pointer to and size of bytes in incoming buffer how much is there,
+     * but not more `number`. Pointer is valid until the buffer is changed.
+     */
+    std::pair<const char*, size_t> peek(size_t number) const noexcept {
+        number = (number < size()) ? number : size();
+        return std::make_pair(buff.data(), number);
+    }
+
+    /* Returns pointer to and size of the data ready by buffer task, or of nothing. */
+    std::pair<const char*, size_t> peek() const noexcept {
+        auto result = lastResult();
+        return peek((result > 0) ? result : 0);
+    }
+
+    /* Drops from incoming buffer how much is there, but not more `number` bytes. */
+    void consume(size_t number) {
         number = (number < size()) ? number : size();
         if (number > 0) {
-            std::copy(buff.begin(), buff.begin() + number, std::back_inserter(result));
-            buff.erase(buff.begin(), buff.begin() + number);
+            buff.consume(number);
+            scanned = 0;
             resume();
         }
-        return result;
     }
 
   protected:
     Receiver receiver;
+    Renotify renotify;
     std::vector<char> delimiter;
-    size_t threshold;
+    size_t threshold, budget, iterations;
+    mutable size_t scanned;
     int mode;
 
     /* Constructor */
     IncomingBuffer(Receiver&& receiver, FlowCtrl&& flow_ctrl, size_t block_size, size_t max_size)
         : BaseBuffer(std::forward<FlowCtrl>(flow_ctrl), block_size, max_size),
-          receiver(std::forward<Receiver>(receiver)), threshold(max_size), mode(Event::READ) {
+          receiver(std::forward<Receiver>(receiver)), threshold(max_size), budget(block_size), iterations(0),
+          scanned(0), mode(Event::READ) {
         resume();
     }
 
+    /* Receives to buffer how much is there, but not more `number` bytes. */
+    std::pair<size_t, int> receive(size_t number) {
+        auto receiver_result = receiver(buff.prepare(number), number);
+        buff.commit(receiver_result.first);
+        return receiver_result;
+    }
+
+    /*
+     * Receives to buffer by drain budget; returns result of the first receiver call
+     * with total number of received bytes. Data followed by EOF or error are
+     * returned as received; EOF or error is left to be found by the next event.
+     */
+    std::pair<size_t, int> drain() {
+        std::pair<size_t, int> result(0, 0);
+        for (size_t call = 0; (iterations == 0) || (call < iterations); call++) {
+            auto number = max_size - size();
+            number = (number < budget - result.first) ? number : budget - result.first;
+            number = (number < block_size) ? number : block_size;
+            if (number == 0) {
+                if ((result.first == budget) && renotify)
+                    renotify();
+                return result;
+            }
+            auto receiver_result = receive(number);
+            if (call == 0)
+                result.second = receiver_result.second;
+            result.first += receiver_result.first;
+            if (receiver_result.first < number) {
+                // EOF or error after received data
+                if ((call > 0) && (receiver_result.first == 0) && (receiver_result.second != EAGAIN) &&
+                    (receiver_result.second != EWOULDBLOCK) && renotify)
+                    renotify();
+                return result;
+            }
+        }
+        if (renotify)
+            renotify();
+        return result;
+    }
+
+    /*
+     * Returns offset of the delimiter or `size()` if it is not found.
+     * Search resumes from where the previous one stopped, backed off
+     * by delimiter length - 1, so received data is scanned only once.
+     */
+    size_t searchDelimiter() const noexcept {
+        auto begin = buff.data(), end = begin + buff.size();
+        auto from = (scanned <= size()) ? begin + scanned : begin;
+        auto found = searchBytes(from, end, delimiter.data(), delimiter.size());
+        if (found != end)
+            scanned = found - begin;
+        else if (size() >= delimiter.size())
+            scanned = size() - delimiter.size() + 1;
+        return found - begin;
+    }
+
     void operator()(int revents) {
         if (revents & (mode | Event::ERROR)) {
             last_error = 0;
             if (revents == mode) {
                 revents = 0;
-                auto number = max_size - size();
-                number = (number < block_size) ? number : block_size;
-                if (number > 0) {
-                    auto from = size();
-                    buff.resize(buff.size() + number);
-                    auto receiver_result = receiver(&(*(buff.begin() + from)), number);
-                    if (receiver_result.first != number)
-                        buff.resize(buff.size() - number + receiver_result.first);
+                if (size() < max_size) {
+                    auto receiver_result = drain();
                     if (receiver_result.first == 0) {
                         revents = Event::BUFFER | Event::ERROR;
                         if (receiver_result.second > 0)
@@ -259,21 +562,179 @@ class IncomingBuffer : public BaseBuffer {
             if ((revents & Event::ERROR) || (size() >= max_size))
                 pause();
             if (on_event) {
-                OnEvent callback = on_event;
                 if (!((revents & Event::ERROR))) {
                     auto result = lastResult();
                     if (result > 0)
                         revents = Event::BUFFER | Event::READ;
                     else if (result < 0)
                         revents = Event::BUFFER | Event::ERROR | Event::READ;
+                    if (revents)
+                        on_event(revents, (void*)this);
                 } else
-                    cancel();
-                if (revents)
-                    callback(revents, (void*)this);
+                    on_event.resetAndCall(revents, (void*)this); // cancels buffer task
+            }
+        }
+    }
+};
+
+
+#ifdef HAVE_UNISTD_H
+/*
+ * Event-driven outcoming buffer which holds a chain of owned or refcounted
+ * segments and transmits up to IOV_MAX of them by one vectored call.
+ * Small writes are coalesced into owned segments; large ones are never copied.
+ * Unlike `OutcomingBuffer`, a WRITE event is not limited by `block_size`;
+ * it only sizes owned segments.
+ */
+class SegmentedOutcomingBuffer : public BasicOutcomingBuffer<SegmentedOutcomingBuffer> {
+    friend class BasicOutcomingBuffer<SegmentedOutcomingBuffer>;
+
+  public:
+    /* Data vectored transmiter interface */
+    using Transmiter = std::function<std::pair<size_t, int>(const struct iovec* iov, int iovcnt)>;
+
+    using BasicOutcomingBuffer<SegmentedOutcomingBuffer>::write;
+
+    /* Returns current buffer size; it hides `BaseBuffer::size`, which does not count segments. */
+    size_t size() const noexcept {
+        return total;
+    }
+
+    /* Returns number of buffered segments. */
+    size_t segments() const noexcept {
+        return chain.size();
+    }
+
+    /* Release buffer; it hides `BaseBuffer::cleanup` to drop segments too. */
+    void cleanup() noexcept {
+        BaseBuffer::cleanup();
+        clear();
+    }
+
+    /* Copies data to the outcoming buffer. Returns number of written bytes. */
+    size_t write(const char* data, size_t number) {
+        auto available = max_size - size();
+        number = (number < available) ? number : available;
+        if (number > 0) {
+            if (chain.empty() || chain.back().shared ||
+                (chain.back().owned.capacity() - chain.back().owned.size() < number)) {
+                chain.emplace_back();
+                chain.back().owned.reserve((number > block_size) ? number : block_size);
+            }
+            auto& segment = chain.back();
+            segment.owned.insert(segment.owned.end(), data, data + number);
+            segment.data = segment.owned.data();
+            segment.size = segment.owned.size();
+            total += number;
+            resume();
+            return number;
+        }
+        return 0;
+    }
+
+    /*
+     * Moves data not less than `block_size` to the outcoming buffer as own segment.
+     * Smaller data or data which does not fit entirely is copied
+     * and left untouched. Returns number of written bytes.
+     */
+    size_t write(std::vector<char>&& data) {
+        if ((data.size() < block_size) || (data.size() > max_size - size()))
+            return write(data.data(), data.size());
+        chain.emplace_back();
+        auto& segment = chain.back();
+        segment.owned = std::move(data);
+        segment.data = segment.owned.data();
+        segment.size = segment.owned.size();
+        total += segment.size;
+        resume();
+        return segment.size;
+    }
+
+    /*
+     * Adds refcounted data to the outcoming buffer as own segment
+     * how much is there, but not more `number` bytes. Returns number of written bytes.
+     */
+    size_t write(std::shared_ptr<const char> data, size_t number) {
+        auto available = max_size - size();
+        number = (number < available) ? number : available;
+        if (number > 0) {
+            chain.emplace_back();
+            auto& segment = chain.back();
+            segment.shared = std::move(data);
+            segment.data = segment.shared.get();
+            segment.size = number;
+            total += number;
+            resume();
+            return number;
+        }
+        return 0;
+    }
+
+  protected:
+#ifdef IOV_MAX
+    enum : int { MAX_IOV = IOV_MAX };
+#else
+    enum : int { MAX_IOV = 1024 };
+#endif
+
+    /* Buffer segment */
+    struct Segment {
+        std::vector<char> owned;
+        std::shared_ptr<const char> shared;
+        const char* data = nullptr;
+        size_t size = 0, sent = 0;
+    };
+
+    Transmiter transmiter;
+    std::deque<Segment> chain;
+    std::vector<struct iovec> iov;
+    size_t total;
+
+    /* Constructor */
+    SegmentedOutcomingBuffer(Transmiter&& transmiter, FlowCtrl&& flow_ctrl, size_t block_size, size_t max_size)
+        : BasicOutcomingBuffer<SegmentedOutcomingBuffer>(std::forward<FlowCtrl>(flow_ctrl), block_size, max_size),
+          transmiter(std::forward<Transmiter>(transmiter)), total(0) {
+        resume();
+    }
+
+    /* Drops buffered data. */
+    void clear() noexcept {
+        chain.clear();
+        total = 0;
+    }
+
+    /* Drops `number` transmited bytes from the front of chain. */
+    void consume(size_t number) noexcept {
+        while ((number > 0) && !chain.empty()) {
+            auto& segment = chain.front();
+            auto rest = segment.size - segment.sent;
+            if (number < rest) {
+                segment.sent += number;
+                total -= number;
+                break;
             }
+            number -= rest;
+            total -= rest;
+            chain.pop_front();
+        }
+    }
+
+    /* Transmits up to `MAX_IOV` segments from the front of chain. */
+    std::pair<size_t, int> transmit() {
+        iov.clear();
+        for (auto it = chain.begin(); (it != chain.end()) && (iov.size() < size_t(MAX_IOV)); ++it) {
+            struct iovec vec;
+            vec.iov_base = const_cast<char*>(it->data + it->sent);
+            vec.iov_len = it->size - it->sent;
+            iov.push_back(vec);
         }
+        auto transmiter_result = transmiter(iov.data(), int(iov.size()));
+        if (transmiter_result.first > 0)
+            consume(transmiter_result.first);
+        return transmiter_result;
     }
 };
+#endif
 
 } // squall::core
 } // squall
@@ -4,12 +4,13 @@
 #include <memory>
 #include <utility>
 #include <functional>
-#include <unordered_map>
 #include <unordered_set>
 #include "Exceptions.hxx"
 #include "NonCopyable.hxx"
 #include "PlatformLoop.hxx"
 #include "PlatformWatchers.hxx"
+#include "TimingWheel.hxx"
+#include "WatcherStorage.hxx"
 
 using std::placeholders::_1;
 using std::placeholders::_2;
@@ -18,11 +19,88 @@ namespace squall {
 namespace core {
 
 
-/* Contexted event dispatcher. */
-template <typename Ctx>
+/*
+ * Contexted event dispatcher.
+ * `Handler` is callable as `void(Ctx ctx, int revents, void* payload)`;
+ * by default it is `std::function`, but any functor type may be given,
+ * then each event is a direct call which compiler is able to inline.
+ * `Storage` is a policy keeping watchers by context, see `WatcherStorage.hxx`.
+ */
+template <typename Ctx, typename Handler = std::function<void(Ctx ctx, int revents, void* payload)>,
+          template <typename, typename> class Storage = HashStorage>
 class Dispatcher : NonCopyable {
 
-    using CtxTarget = std::function<void(Ctx ctx, int revents, void* payload)>;
+    /* Event watcher which keeps `ctx` inline and calls dispatcher handler directly. */
+    template <typename EV>
+    class CtxWatcher : public RawWatcher<EV> {
+      public:
+        /* Constructor */
+        CtxWatcher(Dispatcher* p_disp, const Ctx& ctx)
+            : RawWatcher<EV>(CtxWatcher::callback, p_disp->sharedLoop()), p_disp(p_disp), ctx(ctx) {}
+
+        /* Returns underlying libev watcher. */
+        const EV& raw() const noexcept {
+            return this->ev;
+        }
+
+      private:
+        Dispatcher* p_disp;
+        Ctx ctx;
+
+        static void callback(struct ev_loop* p_loop, EV* p_ev_watcher, int revents) {
+            auto p_watcher = static_cast<CtxWatcher*>(reinterpret_cast<RawWatcher<EV>*>(p_ev_watcher));
+            // handler may cancel this watcher, so it gets a copy of `ctx`
+            Ctx ctx = p_watcher->ctx;
+            p_watcher->p_disp->ctx_target(ctx, revents, (void*)p_watcher);
+        }
+    };
+
+    /* One-shot timeout which keeps `ctx` inline; it is armed on timing wheel of dispatcher. */
+    class TimeoutWatcher : public TimingWheel::Node {
+      public:
+        /* Constructor */
+        TimeoutWatcher(Dispatcher* p_disp, const Ctx& ctx)
+            : TimingWheel::Node(TimeoutWatcher::callback), p_disp(p_disp), ctx(ctx) {}
+
+      private:
+        Dispatcher* p_disp;
+        Ctx ctx;
+
+        static void callback(TimingWheel::Node* p_node) {
+            auto p_watcher = static_cast<TimeoutWatcher*>(p_node);
+            auto p_disp = p_watcher->p_disp;
+            Ctx ctx = p_watcher->ctx;
+            p_disp->timeout_watchers.erase(ctx); // expired timeout is released before call
+            p_disp->ctx_target(ctx, Event::TIMEOUT, nullptr);
+        }
+    };
+
+    /* Activity timeout which keeps `ctx` inline and calls dispatcher handler directly. */
+    class ActivityWatcher : public ActivityTimer {
+      public:
+        /* Constructor */
+        ActivityWatcher(Dispatcher* p_disp, const Ctx& ctx)
+            : ActivityTimer(ActivityWatcher::callback, p_disp->sharedLoop()), p_disp(p_disp), ctx(ctx) {}
+
+      private:
+        Dispatcher* p_disp;
+        Ctx ctx;
+
+        static void callback(struct ev_loop* p_loop, ev_timer* p_ev_watcher, int revents) {
+            auto p_watcher = static_cast<ActivityWatcher*>(reinterpret_cast<RawWatcher<ev_timer>*>(p_ev_watcher));
+            if (p_watcher->expired()) {
+                Ctx ctx = p_watcher->ctx;
+                p_watcher->p_disp->ctx_target(ctx, Event::TIMEOUT, (void*)p_watcher);
+            }
+        }
+    };
+
+    using IoWatcher = CtxWatcher<ev_io>;
+    using TimerWatcher = CtxWatcher<ev_timer>;
+    using SignalWatcher = CtxWatcher<ev_signal>;
+    using PrepareWatcher = CtxWatcher<ev_prepare>;
+    using CheckWatcher = CtxWatcher<ev_check>;
+    using IdleWatcher = CtxWatcher<ev_idle>;
 
   public:
     /** Returns true if this dispatcher is active. */
@@ -39,9 +117,26 @@ class Dispatcher : NonCopyable {
     }
 
 
+    /**
+     * Returns tick resolution in seconds of timeouts
+     * established with method `setupTimeoutWatching`.
+     */
+    double timeoutResolution() const noexcept {
+        return timeout_resolution;
+    }
+
+
     /** Constructor */
-    Dispatcher(CtxTarget&& ctx_target, const std::shared_ptr<PlatformLoop>& sp_loop)
-        : ctx_target(std::forward<CtxTarget>(ctx_target)), sp_loop(sp_loop) {}
+    Dispatcher(Handler&& ctx_target, const std::shared_ptr<PlatformLoop>& sp_loop,
+               double timeout_resolution = 0.1)
+        : ctx_target(std::forward<Handler>(ctx_target)), sp_loop(sp_loop),
+          timeout_resolution(TimingWheel::validResolution(timeout_resolution)) {}
+
+    /** Constructor */
+    Dispatcher(const Handler& ctx_target, const std::shared_ptr<PlatformLoop>& sp_loop,
+               double timeout_resolution = 0.1)
+        : ctx_target(ctx_target), sp_loop(sp_loop),
+          timeout_resolution(TimingWheel::validResolution(timeout_resolution)) {}
 
 
     /** Destructor */
@@ -55,18 +150,27 @@ class Dispatcher : NonCopyable {
     void release() {
         if (active()) {
             std::unordered_set<Ctx> ctx_to_cleanup;
-            for (auto const& pair : io_watchers)
-                ctx_to_cleanup.insert(pair.first);
-            for (auto const& pair : timer_watchers)
-                ctx_to_cleanup.insert(pair.first);
-            for (auto const& pair : signal_watchers)
-                ctx_to_cleanup.insert(pair.first);
+            auto collect = [&ctx_to_cleanup](const Ctx& ctx) { ctx_to_cleanup.insert(ctx); };
+            io_watchers.forEach(collect);
+            timer_watchers.forEach(collect);
+            signal_watchers.forEach(collect);
+            prepare_watchers.forEach(collect);
+            check_watchers.forEach(collect);
+            idle_watchers.forEach(collect);
+            timeout_watchers.forEach(collect);
+            activity_watchers.forEach(collect);
             for (auto const& ctx : ctx_to_cleanup) {
                 cancelIoWatching(ctx);
                 cancelTimerWatching(ctx);
                 cancelSignalWatching(ctx);
+                cancelPrepareWatching(ctx);
+                cancelCheckWatching(ctx);
+                cancelIdleWatching(ctx);
+                cancelTimeoutWatching(ctx);
+                cancelActivityWatching(ctx);
                 ctx_target(ctx, Event::CLEANUP, nullptr);
             }
+            up_wheel.reset();
             sp_loop.reset();
         }
     }
@@ -77,20 +181,14 @@ class Dispatcher : NonCopyable {
      */
     void setupIoWatching(Ctx ctx, int fd, int mode) {
         if (active()) {
-            auto found = io_watchers.find(ctx);
-            if (found != io_watchers.end()) {
-                auto p_watcher = found->second.get();
+            auto p_watcher = io_watchers.find(ctx);
+            if (p_watcher != nullptr) {
+                if (p_watcher->setup(fd, mode))
+                    return;
+            } else if ((p_watcher = io_watchers.emplace(ctx, this, ctx)) != nullptr) {
                 if (p_watcher->setup(fd, mode))
                     return;
-            } else {
-                auto up_watcher = std::unique_ptr<IoWatcher>(
-                    new IoWatcher(std::bind(ctx_target, ctx, _1, _2), sharedLoop()));
-                if (up_watcher->setup(fd, mode)) {
-                    auto result = io_watchers.insert(std::make_pair(ctx, std::move(up_watcher)));
-                    if (result.second)
-                        return;
-                    up_watcher->cancel();
-                }
+                io_watchers.erase(ctx);
             }
         }
         throw exc::CannotSetupWatching();
@@ -102,26 +200,44 @@ class Dispatcher : NonCopyable {
      */
     bool updateIoWatching(Ctx ctx, int mode) {
         if (active()) {
-            auto found = io_watchers.find(ctx);
-            if (found != io_watchers.end()) {
-                auto p_watcher = found->second.get();
-                if (p_watcher->setup(p_watcher->fd(), mode))
+            auto p_watcher = io_watchers.find(ctx);
+            if (p_watcher != nullptr) {
+                if (p_watcher->setup(p_watcher->raw().fd, mode))
                     return true;
             }
         }
         return false;
     }
 
+    /**
+     * Feeds `revents` to event watchig established with method `setup_io`
+     * for a given `ctx` as if the device reported them; they are handled
+     * at the next loop iteration unless watching is canceled before.
+     * Watching is level-triggered, so a device which still has data
+     * is reported again anyway; feeding only lets the handler be called
+     * without a device event, e.g. for data which is already buffered.
+     */
+    bool feedIoWatching(Ctx ctx, int revents) {
+        if (active()) {
+            auto p_watcher = io_watchers.find(ctx);
+            if (p_watcher != nullptr) {
+                p_watcher->feed(revents);
+                return true;
+            }
+        }
+        return false;
+    }
+
     /**
      * Cancels an event watchig established
      * with method `setup_io` for a given `ctx`.
      */
     bool cancelIoWatching(Ctx ctx) {
         if (active()) {
-            auto found = io_watchers.find(ctx);
-            if (found != io_watchers.end()) {
-                found->second.get()->cancel();
-                io_watchers.erase(found);
+            auto p_watcher = io_watchers.find(ctx);
+            if (p_watcher != nullptr) {
+                p_watcher->cancel();
+                io_watchers.erase(ctx);
                 return true;
             }
         }
@@ -135,20 +251,14 @@ class Dispatcher : NonCopyable {
     void setupTimerWatching(Ctx ctx, double seconds) {
         if (active()) {
             seconds = (seconds > 0) ? seconds : 0;
-            auto found = timer_watchers.find(ctx);
-            if (found != timer_watchers.end()) {
-                auto p_watcher = found->second.get();
+            auto p_watcher = timer_watchers.find(ctx);
+            if (p_watcher != nullptr) {
                 if (p_watcher->setup(seconds, seconds))
                     return;
-            } else {
-                auto up_watcher = std::unique_ptr<TimerWatcher>(
-                    new TimerWatcher(std::bind(ctx_target, ctx, _1, _2), sharedLoop()));
-                if (up_watcher->setup(seconds, seconds)) {
-                    auto result = timer_watchers.insert(std::make_pair(ctx, std::move(up_watcher)));
-                    if (result.second)
-                        return;
-                    up_watcher->cancel();
-                }
+            } else if ((p_watcher = timer_watchers.emplace(ctx, this, ctx)) != nullptr) {
+                if (p_watcher->setup(seconds, seconds))
+                    return;
+                timer_watchers.erase(ctx);
             }
         }
         throw exc::CannotSetupWatching();
@@ -160,10 +270,10 @@ class Dispatcher : NonCopyable {
      */
     bool cancelTimerWatching(Ctx ctx) {
         if (active()) {
-            auto found = timer_watchers.find(ctx);
-            if (found != timer_watchers.end()) {
-                found->second.get()->cancel();
-                timer_watchers.erase(found);
+            auto p_watcher = timer_watchers.find(ctx);
+            if (p_watcher != nullptr) {
+                p_watcher->cancel();
+                timer_watchers.erase(ctx);
                 return true;
             }
         }
@@ -176,20 +286,14 @@ class Dispatcher : NonCopyable {
      */
     void setupSignalWatching(Ctx ctx, int signum) {
         if (active()) {
-            auto found = signal_watchers.find(ctx);
-            if (found != signal_watchers.end()) {
-                auto p_watcher = found->second.get();
+            auto p_watcher = signal_watchers.find(ctx);
+            if (p_watcher != nullptr) {
                 if (p_watcher->setup(signum))
                     return;
-            } else {
-                auto up_watcher = std::unique_ptr<SignalWatcher>(
-                    new SignalWatcher(std::bind(ctx_target, ctx, _1, _2), sharedLoop()));
-                if (up_watcher->setup(signum)) {
-                    auto result = signal_watchers.insert(std::make_pair(ctx, std::move(up_watcher)));
-                    if (result.second)
-                        return;
-                    up_watcher->cancel();
-                }
+            } else if ((p_watcher = signal_watchers.emplace(ctx, this, ctx)) != nullptr) {
+                if (p_watcher->setup(signum))
+                    return;
+                signal_watchers.erase(ctx);
             }
         }
         throw exc::CannotSetupWatching();
@@ -201,10 +305,202 @@ class Dispatcher : NonCopyable {
      */
     bool cancelSignalWatching(Ctx ctx) {
         if (active()) {
-            auto found = signal_watchers.find(ctx);
-            if (found != signal_watchers.end()) {
-                found->second.get()->cancel();
-                signal_watchers.erase(found);
+            auto p_watcher = signal_watchers.find(ctx);
+            if (p_watcher != nullptr) {
+                p_watcher->cancel();
+                signal_watchers.erase(ctx);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /**
+     * Setup to call event handler for a given `ctx` with `Event::PREPARE`
+     * at each loop iteration right before the loop polls for events.
+     * It suits work which is batched per iteration, such as flushing
+     * all buffers written by handlers in one pass.
+     */
+    void setupPrepareWatching(Ctx ctx) {
+        if (active()) {
+            auto p_watcher = prepare_watchers.find(ctx);
+            if (p_watcher != nullptr) {
+                if (p_watcher->setup())
+                    return;
+            } else if ((p_watcher = prepare_watchers.emplace(ctx, this, ctx)) != nullptr) {
+                if (p_watcher->setup())
+                    return;
+                prepare_watchers.erase(ctx);
+            }
+        }
+        throw exc::CannotSetupWatching();
+    }
+
+    /**
+     * Cancels an event watchig established
+     * with method `setupPrepareWatching` for a given `ctx`.
+     */
+    bool cancelPrepareWatching(Ctx ctx) {
+        if (active()) {
+            auto p_watcher = prepare_watchers.find(ctx);
+            if (p_watcher != nullptr) {
+                p_watcher->cancel();
+                prepare_watchers.erase(ctx);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /**
+     * Setup to call event handler for a given `ctx` with `Event::CHECK`
+     * at each loop iteration right after the loop has polled for events.
+     */
+    void setupCheckWatching(Ctx ctx) {
+        if (active()) {
+            auto p_watcher = check_watchers.find(ctx);
+            if (p_watcher != nullptr) {
+                if (p_watcher->setup())
+                    return;
+            } else if ((p_watcher = check_watchers.emplace(ctx, this, ctx)) != nullptr) {
+                if (p_watcher->setup())
+                    return;
+                check_watchers.erase(ctx);
+            }
+        }
+        throw exc::CannotSetupWatching();
+    }
+
+    /**
+     * Cancels an event watchig established
+     * with method `setupCheckWatching` for a given `ctx`.
+     */
+    bool cancelCheckWatching(Ctx ctx) {
+        if (active()) {
+            auto p_watcher = check_watchers.find(ctx);
+            if (p_watcher != nullptr) {
+                p_watcher->cancel();
+                check_watchers.erase(ctx);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /**
+     * Setup to call event handler for a given `ctx` with `Event::IDLE`
+     * at each loop iteration when there are no other pending events.
+     * While it is set up, the loop polls without blocking, so it suits
+     * low-priority work which is to be canceled when done.
+     */
+    void setupIdleWatching(Ctx ctx) {
+        if (active()) {
+            auto p_watcher = idle_watchers.find(ctx);
+            if (p_watcher != nullptr) {
+                if (p_watcher->setup())
+                    return;
+            } else if ((p_watcher = idle_watchers.emplace(ctx, this, ctx)) != nullptr) {
+                if (p_watcher->setup())
+                    return;
+                idle_watchers.erase(ctx);
+            }
+        }
+        throw exc::CannotSetupWatching();
+    }
+
+    /**
+     * Cancels an event watchig established
+     * with method `setupIdleWatching` for a given `ctx`.
+     */
+    bool cancelIdleWatching(Ctx ctx) {
+        if (active()) {
+            auto p_watcher = idle_watchers.find(ctx);
+            if (p_watcher != nullptr) {
+                p_watcher->cancel();
+                idle_watchers.erase(ctx);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /**
+     * Setup to call event handler for a given `ctx` once after `seconds`
+     * rounded up to timeout resolution; established timeout is re-armed.
+     * Unlike `setupTimerWatching` it uses a timing wheel with O(1)
+     * arm and cancel, which suits many frequently reset timeouts.
+     * The timing wheel is created on the first call.
+     */
+    void setupTimeoutWatching(Ctx ctx, double seconds) {
+        if (active()) {
+            if (!up_wheel)
+                up_wheel.reset(new TimingWheel(sp_loop, timeout_resolution));
+            auto p_watcher = timeout_watchers.find(ctx);
+            if (p_watcher == nullptr)
+                p_watcher = timeout_watchers.emplace(ctx, this, ctx);
+            if (p_watcher != nullptr) {
+                up_wheel->arm(p_watcher, seconds);
+                return;
+            }
+        }
+        throw exc::CannotSetupWatching();
+    }
+
+    /**
+     * Cancels an event watchig established
+     * with method `setupTimeoutWatching` for a given `ctx`.
+     */
+    bool cancelTimeoutWatching(Ctx ctx) {
+        if (active())
+            return timeout_watchers.erase(ctx);
+        return false;
+    }
+
+    /**
+     * Setup to call event handler for a given `ctx` when
+     * `touchActivityWatching` was not called for `seconds`.
+     * Established watching is restarted; expired one stops
+     * and is to be set up again or canceled.
+     */
+    void setupActivityWatching(Ctx ctx, double seconds) {
+        if (active()) {
+            auto p_watcher = activity_watchers.find(ctx);
+            if (p_watcher != nullptr) {
+                if (p_watcher->setup(seconds))
+                    return;
+            } else if ((p_watcher = activity_watchers.emplace(ctx, this, ctx)) != nullptr) {
+                if (p_watcher->setup(seconds))
+                    return;
+                activity_watchers.erase(ctx);
+            }
+        }
+        throw exc::CannotSetupWatching();
+    }
+
+    /**
+     * Marks activity for event watchig established
+     * with method `setupActivityWatching` for a given `ctx`.
+     * It only stores loop time, so it is cheap to call on every packet.
+     */
+    bool touchActivityWatching(Ctx ctx) noexcept {
+        auto p_watcher = activity_watchers.find(ctx);
+        if (p_watcher != nullptr) {
+            p_watcher->touch();
+            return true;
+        }
+        return false;
+    }
+
+    /**
+     * Cancels an event watchig established
+     * with method `setupActivityWatching` for a given `ctx`.
+     */
+    bool cancelActivityWatching(Ctx ctx) {
+        if (active()) {
+            auto p_watcher = activity_watchers.find(ctx);
+            if (p_watcher != nullptr) {
+                p_watcher->cancel();
+                activity_watchers.erase(ctx);
                 return true;
             }
         }
@@ -212,12 +508,24 @@ class Dispatcher : NonCopyable {
     }
 
   private:
-    CtxTarget ctx_target;
+    Handler ctx_target;
     std::shared_ptr<PlatformLoop> sp_loop;
-    std::unordered_map<Ctx, std::unique_ptr<IoWatcher>> io_watchers;
-    std::unordered_map<Ctx, std::unique_ptr<TimerWatcher>> timer_watchers;
-    std::unordered_map<Ctx, std::unique_ptr<SignalWatcher>> signal_watchers;
+    double timeout_resolution;
+    std::unique_ptr<TimingWheel> up_wheel;
+    Storage<Ctx, IoWatcher> io_watchers;
+    Storage<Ctx, TimerWatcher> timer_watchers;
+    Storage<Ctx, SignalWatcher> signal_watchers;
+    Storage<Ctx, PrepareWatcher> prepare_watchers;
+    Storage<Ctx, CheckWatcher> check_watchers;
+    Storage<Ctx, IdleWatcher> idle_watchers;
+    Storage<Ctx, TimeoutWatcher> timeout_watchers;
+    Storage<Ctx, ActivityWatcher> activity_watchers;
 };
+
+
+/* Dispatcher which contexts are file descriptors; watchers are indexed by fd. */
+template <typename Handler = std::function<void(int fd, int revents, void* payload)>>
+using FdDispatcher = Dispatcher<int, Handler, FdStorage>;
 } // squall::core
 } // squall
 #endif // SQUALL__CORE__DISPATCHER_HXX
\ No newline at end of file
@@ -0,0 +1,223 @@
+#ifndef SQUALL__CORE__EPOLL_LOOP_HXX
+#define SQUALL__CORE__EPOLL_LOOP_HXX
+#ifdef HAVE_EPOLL_H
+#include <vector>
+#include <memory>
+#include <cerrno>
+#include <cstdint>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include "Exceptions.hxx"
+#include "NonCopyable.hxx"
+#include "PlatformLoop.hxx"
+
+namespace squall {
+namespace core {
+
+
+/*
+ * Native epoll event loop for I/O; a standalone alternative to `PlatformLoop`
+ * without libev indirection. Pointers to watchers are stored right
+ * in `epoll_event.data`, one `epoll_wait` fetches up to `batch` events
+ * and watchers may be edge-triggered. It is not a `PlatformLoop` backend:
+ * `Dispatcher`, buffers and timers cannot run on it, and it handles only
+ * I/O events of its own `EpollWatcher`s.
+ */
+class EpollLoop : NonCopyable {
+    friend class EpollWatcher;
+
+  public:
+    /* Return true if is running */
+    bool running() const noexcept {
+        return running_;
+    }
+
+    /* Returns max number of events fetched at once. */
+    size_t batch() const noexcept {
+        return events.size();
+    }
+
+    /* Returns created pointer to new loop */
+    static std::shared_ptr<EpollLoop> createShared(size_t batch = 64) {
+        return std::shared_ptr<EpollLoop>(new EpollLoop(batch));
+    }
+
+    /* Returns created pointer to new loop which batch is given by `options`. */
+    static std::shared_ptr<EpollLoop> createShared(const PlatformLoop::Options& options) {
+        return std::shared_ptr<EpollLoop>(new EpollLoop(options.epoll_batch));
+    }
+
+    /* Destructor. */
+    ~EpollLoop() {
+        close(epoll_fd);
+    }
+
+    /* Starts event dispatching; it returns when stopped or nothing is watched. */
+    void start() {
+        // handler or failed wait may throw out of here
+        struct Running {
+            bool& running;
+            ~Running() {
+                running = false;
+            }
+        } running{running_};
+        running_ = true;
+        while (running_ && runOnce(-1)) {
+        }
+    }
+
+    /* Stops event dispatching; events already fetched are handled. */
+    void stop() noexcept {
+        running_ = false;
+    }
+
+    /*
+     * Waits up to `timeout_ms` for events and handles them; returns false
+     * if nothing is watched. Throws `exc::CannotSetupWatching` if waiting fails.
+     */
+    bool runOnce(int timeout_ms = 0);
+
+  private:
+    int epoll_fd;
+    bool running_ = false;
+    size_t watching = 0, next = 0, fetched = 0;
+    std::vector<struct epoll_event> events;
+
+    /* Constructor. */
+    EpollLoop(size_t batch) : events(batch > 0 ? batch : 1) {
+        epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+        if (epoll_fd < 0)
+            throw exc::CannotSetupWatching("Cannot create epoll instance");
+    }
+
+    /* Drops not handled events of `p_watcher` fetched at this iteration. */
+    void forget(void* p_watcher) noexcept {
+        for (auto i = next; i < fetched; i++)
+            if (events[i].data.ptr == p_watcher)
+                events[i].data.ptr = nullptr;
+    }
+};
+
+
+/* I/O watcher of `EpollLoop`; it mirrors `IoWatcher`. */
+class EpollWatcher : NonCopyable {
+    friend class EpollLoop;
+
+  public:
+    /* Constructor */
+    EpollWatcher(OnEvent&& on_event, const std::shared_ptr<EpollLoop>& sp_loop)
+        : on_event(std::forward<OnEvent>(on_event)), p_loop(sp_loop.get()) {}
+
+    /* Destructor */
+    ~EpollWatcher() {
+        cancel();
+    }
+
+    /* Return true if this is running. */
+    bool running() const noexcept {
+        return running_;
+    }
+
+    /* File descriptor */
+    int fd() const noexcept {
+        return fd_;
+    }
+
+    /* Current watching mode */
+    int mode() const noexcept {
+        return mode_;
+    }
+
+    /* Returns true if this is edge-triggered. */
+    bool edge() const noexcept {
+        return edge_;
+    }
+
+    /*
+     * Sets up to starts an event watching; running watcher of the same fd
+     * is modified in place. Failed setup leaves this canceled. Edge-triggered watcher is called only when
+     * the device state changes, so handler must read or write until EAGAIN.
+     */
+    bool setup(int fd, int mode, bool edge = false) {
+        mode = (mode & (Event::READ | Event::WRITE));
+        if ((fd < 0) || (mode == 0)) {
+            cancel();
+            return false;
+        }
+        struct epoll_event event = {};
+        event.events = ((mode & Event::READ) ? uint32_t(EPOLLIN | EPOLLRDHUP) : 0) |
+                       ((mode & Event::WRITE) ? uint32_t(EPOLLOUT) : 0) | (edge ? uint32_t(EPOLLET) : 0);
+        event.data.ptr = this;
+        if (running_ && (fd == fd_)) {
+            if (epoll_ctl(p_loop->epoll_fd, EPOLL_CTL_MOD, fd, &event) != 0) {
+                // fd was closed, so the kernel has removed it, and its number is reused
+                if ((errno != ENOENT) || (epoll_ctl(p_loop->epoll_fd, EPOLL_CTL_ADD, fd, &event) != 0)) {
+                    cancel();
+                    return false;
+                }
+                p_loop->forget(this); // fetched events are of closed one
+            }
+        } else {
+            cancel();
+            if (epoll_ctl(p_loop->epoll_fd, EPOLL_CTL_ADD, fd, &event) != 0)
+                return false;
+            running_ = true;
+            p_loop->watching++;
+        }
+        fd_ = fd;
+        mode_ = mode;
+        edge_ = edge;
+        return true;
+    }
+
+    /* Cancels an event watching. */
+    bool cancel() noexcept {
+        if (!running_)
+            return false;
+        // fd may be already closed, then the kernel has removed it itself
+        epoll_ctl(p_loop->epoll_fd, EPOLL_CTL_DEL, fd_, nullptr);
+        running_ = false;
+        p_loop->watching--;
+        p_loop->forget(this);
+        return true;
+    }
+
+  private:
+    OnEvent on_event;
+    EpollLoop* p_loop;
+    int fd_ = -1, mode_ = 0;
+    bool edge_ = false, running_ = false;
+};
+
+
+inline bool EpollLoop::runOnce(int timeout_ms) {
+    if (watching == 0)
+        return false;
+    auto result = epoll_wait(epoll_fd, events.data(), int(events.size()), timeout_ms);
+    if (result < 0) {
+        if (errno == EINTR)
+            return true;
+        throw exc::CannotSetupWatching("Cannot wait for epoll events");
+    }
+    fetched = size_t(result);
+    for (next = 0; next < fetched;) {
+        auto& event = events[next++];
+        auto p_watcher = static_cast<EpollWatcher*>(event.data.ptr);
+        if (p_watcher == nullptr)
+            continue; // canceled by handler of previous event
+        int revents = ((event.events & (EPOLLIN | EPOLLRDHUP)) ? Event::READ : 0) |
+                      ((event.events & EPOLLOUT) ? Event::WRITE : 0);
+        // as libev does, errors are reported as readiness, so handler gets them on I/O
+        if (event.events & (EPOLLERR | EPOLLHUP))
+            revents |= p_watcher->mode_;
+        revents &= p_watcher->mode_;
+        if (revents != 0)
+            p_watcher->on_event(revents, (void*)p_watcher);
+    }
+    next = fetched = 0;
+    return true;
+}
+} // squall::core
+} // squall
+#endif // HAVE_EPOLL_H
+#endif // SQUALL__CORE__EPOLL_LOOP_HXX
@@ -11,6 +11,12 @@ class CannotSetupWatching : public std::runtime_error {
     CannotSetupWatching(std::string message = "")
         : std::runtime_error(message.size() > 0 ? message : "Cannot setup an event watching") {}
 };
+
+class CannotListen : public std::runtime_error {
+  public:
+    CannotListen(std::string message = "")
+        : std::runtime_error(message.size() > 0 ? message : "Cannot listen a socket") {}
+};
 } // squall::exc
 } // squall
 #endif // SQUALL__CORE__EXCEPTIONS_HXX
\ No newline at end of file
@@ -0,0 +1,166 @@
+#ifndef SQUALL__CORE__LOOP_GROUP_HXX
+#define SQUALL__CORE__LOOP_GROUP_HXX
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <exception>
+#include <functional>
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+#include "Exceptions.hxx"
+#include "NonCopyable.hxx"
+#include "PlatformLoop.hxx"
+#include "TaskQueue.hxx"
+
+namespace squall {
+namespace core {
+
+
+/*
+ * Group of event loops, each runs in its own thread.
+ * Loops share nothing; state of each one is created by `worker` on its
+ * thread, e.g. a dispatcher with a listening socket of `listenSocket`
+ * with `reuse_port`, so connections are balanced by the kernel.
+ * Other threads talk to loops only by posting tasks.
+ */
+class LoopGroup : NonCopyable {
+  public:
+    /*
+     * Worker is called on loop thread before loop starts; returned state
+     * is kept while loop runs and is released on the same thread.
+     */
+    using Worker = std::function<std::shared_ptr<void>(size_t index, const std::shared_ptr<PlatformLoop>& sp_loop)>;
+
+    /* Returns created pointer to new group of `size` loops, zero means a loop per core. */
+    static std::shared_ptr<LoopGroup> createShared(size_t size = 0, bool pin = true) {
+        return std::shared_ptr<LoopGroup>(new LoopGroup(size, pin));
+    }
+
+    /* Destructor */
+    ~LoopGroup() {
+        stop();
+        try {
+            join();
+        } catch (...) {
+        }
+    }
+
+    /* Returns number of loops. */
+    size_t size() const noexcept {
+        return members.size();
+    }
+
+    /* Returns true if threads are started and are not joined. */
+    bool running() const noexcept {
+        return started;
+    }
+
+    /* Returns shared pointer to loop with given `index`. */
+    const std::shared_ptr<PlatformLoop>& loop(size_t index) const {
+        return members.at(index).sp_loop;
+    }
+
+    /* Posts `task` to run on loop with given `index`; thread safe. */
+    void post(size_t index, TaskQueue::Task&& task) {
+        members.at(index).sp_queue->post(std::forward<TaskQueue::Task>(task));
+    }
+
+    /* Starts threads; each calls `worker` and runs its loop. */
+    void start(Worker&& worker) {
+        if (started.exchange(true))
+            throw exc::CannotSetupWatching("Loop group is already started");
+        auto sp_worker = std::make_shared<Worker>(std::forward<Worker>(worker));
+        for (size_t index = 0; index < members.size(); index++)
+            members[index].thread = std::thread(&LoopGroup::run, this, index, sp_worker);
+    }
+
+    /* Asks all loops to stop; thread safe. */
+    void stop() {
+        if (started)
+            for (auto& member : members) {
+                auto p_loop = member.sp_loop.get();
+                member.sp_queue->post([p_loop]() { p_loop->stop(); });
+            }
+    }
+
+    /* Waits for all threads; rethrows the first exception thrown on them. */
+    void join() {
+        for (auto& member : members)
+            if (member.thread.joinable())
+                member.thread.join();
+        started = false;
+        for (auto& member : members)
+            if (member.error) {
+                auto error = member.error;
+                for (auto& other : members)
+                    other.error = nullptr;
+                std::rethrow_exception(error);
+            }
+    }
+
+  private:
+    struct Member {
+        std::shared_ptr<PlatformLoop> sp_loop;
+        std::shared_ptr<TaskQueue> sp_queue;
+        std::thread thread;
+        std::exception_ptr error;
+    };
+
+    std::vector<Member> members;
+    std::atomic<bool> started;
+    bool pin;
+
+    /* Constructor */
+    LoopGroup(size_t size, bool pin) : started(false), pin(pin) {
+        if (size == 0)
+            size = std::thread::hardware_concurrency();
+        members.resize(size > 0 ? size : 1);
+        for (auto& member : members) {
+            member.sp_loop = PlatformLoop::createShared(EVFLAG_AUTO);
+            member.sp_queue = TaskQueue::createShared(member.sp_loop);
+        }
+    }
+
+    /* Thread body */
+    void run(size_t index, std::shared_ptr<Worker> sp_worker) {
+        auto& member = members[index];
+        try {
+            if (pin)
+                pinThread(index);
+            std::shared_ptr<void> sp_state;
+            if (*sp_worker)
+                sp_state = (*sp_worker)(index, member.sp_loop);
+            member.sp_loop->start();
+        } catch (...) {
+            member.error = std::current_exception();
+        }
+    }
+
+    /* Pins current thread to `index`-th core, modulo number of cores allowed for process. */
+    static void pinThread(size_t index) noexcept {
+#ifdef __linux__
+        cpu_set_t allowed;
+        CPU_ZERO(&allowed);
+        if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0)
+            return;
+        auto count = CPU_COUNT(&allowed);
+        if (count == 0)
+            return;
+        index %= count;
+        for (int cpu = 0; cpu < CPU_SETSIZE; cpu++)
+            if (CPU_ISSET(cpu, &allowed) && (index-- == 0)) {
+                cpu_set_t cpuset;
+                CPU_ZERO(&cpuset);
+                CPU_SET(cpu, &cpuset);
+                pthread_setaffinity_np(pthread_self(), sizeof(cpuset), &cpuset);
+                return;
+            }
+#endif
+    }
+};
+} // squall::core
+} // squall
+#endif // SQUALL__CORE__LOOP_GROUP_HXX
@@ -0,0 +1,106 @@
+#ifndef SQUALL__CORE__OFFLOAD_HXX
+#define SQUALL__CORE__OFFLOAD_HXX
+#include <mutex>
+#include <memory>
+#include <utility>
+#include <exception>
+#include <functional>
+#include "NonCopyable.hxx"
+#include "PlatformLoop.hxx"
+#include "TaskQueue.hxx"
+#include "ThreadPool.hxx"
+
+namespace squall {
+namespace core {
+
+
+/*
+ * Contexted offload of CPU-heavy work from a loop to a thread pool.
+ * Work runs on the pool; its completion is posted back and `Handler`
+ * is called on the loop thread as `handler(ctx, revents, payload)`:
+ * with `Event::ASYNC` and nullptr if work is done, or with
+ * `Event::ASYNC | Event::ERROR` and pointer to `std::exception_ptr`
+ * if work threw. Completions of work in flight are dropped when
+ * offload is destroyed. Methods must be called from the loop thread.
+ */
+template <typename Ctx, typename Handler = std::function<void(Ctx ctx, int revents, void* payload)>>
+class Offload : NonCopyable {
+  public:
+    using Work = std::function<void()>;
+
+    /* Constructor */
+    Offload(Handler&& ctx_target, const std::shared_ptr<PlatformLoop>& sp_loop,
+            const std::shared_ptr<ThreadPool>& sp_pool)
+        : ctx_target(std::forward<Handler>(ctx_target)), sp_pool(sp_pool),
+          sp_queue(TaskQueue::createShared(sp_loop)), sp_channel(std::make_shared<Channel>(this)) {}
+
+    /* Destructor */
+    ~Offload() {
+        std::lock_guard<std::mutex> lock(sp_channel->mutex);
+        sp_channel->p_offload = nullptr;
+    }
+
+    /* Returns number of work items which completion is not handled yet. */
+    size_t pending() const noexcept {
+        return pending_;
+    }
+
+    /* Submits `work` to pool; handler will be called for given `ctx` when it is done. */
+    void submit(Ctx ctx, Work&& work) {
+        sp_pool->submit(Job(sp_channel, ctx, std::forward<Work>(work)));
+        pending_++;
+    }
+
+  private:
+    /* Link of workers to offload; it outlives offload while work is in flight. */
+    struct Channel {
+        std::mutex mutex;
+        Offload* p_offload;
+
+        Channel(Offload* p_offload) : p_offload(p_offload) {}
+    };
+
+    /* Pool task which runs work and posts its completion. */
+    struct Job {
+        std::shared_ptr<Channel> sp_channel;
+        Ctx ctx;
+        Work work;
+
+        Job(const std::shared_ptr<Channel>& sp_channel, const Ctx& ctx, Work&& work)
+            : sp_channel(sp_channel), ctx(ctx), work(std::forward<Work>(work)) {}
+
+        void operator()() {
+            std::exception_ptr error;
+            try {
+                work();
+            } catch (...) {
+                error = std::current_exception();
+            }
+            std::lock_guard<std::mutex> lock(sp_channel->mutex);
+            auto p_offload = sp_channel->p_offload;
+            if (p_offload != nullptr) {
+                auto ctx = this->ctx;
+                // queue is owned by offload, so the task never outlives it
+                p_offload->sp_queue->post([p_offload, ctx, error]() { p_offload->complete(ctx, error); });
+            }
+        }
+    };
+
+    Handler ctx_target;
+    std::shared_ptr<ThreadPool> sp_pool;
+    std::shared_ptr<TaskQueue> sp_queue;
+    std::shared_ptr<Channel> sp_channel;
+    size_t pending_ = 0;
+
+    /* Calls handler on the loop thread. */
+    void complete(Ctx ctx, std::exception_ptr error) {
+        pending_--;
+        if (error) {
+            ctx_target(ctx, Event::ASYNC | Event::ERROR, (void*)&error);
+        } else
+            ctx_target(ctx, Event::ASYNC, nullptr);
+    }
+};
+} // squall::core
+} // squall
+#endif // SQUALL__CORE__OFFLOAD_HXX
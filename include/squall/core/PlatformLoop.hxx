@@ -2,8 +2,10 @@
 #define SQUALL__CORE__PLATFORM_LOOP_HXX
 
 #include <ev.h>
+#include <chrono>
 #include <memory>
 #include <functional>
+#include "Exceptions.hxx"
 #include "NonCopyable.hxx"
 
 namespace squall {
@@ -16,11 +18,30 @@ enum Event : int {
     WRITE = EV_WRITE,
     TIMEOUT = EV_TIMER,
     SIGNAL = EV_SIGNAL,
+    ASYNC = EV_ASYNC,
+    PREPARE = EV_PREPARE,
+    CHECK = EV_CHECK,
+    IDLE = EV_IDLE,
     ERROR = EV_ERROR,
     CLEANUP = EV_CLEANUP,
     BUFFER = EV_CUSTOM,
 };
 
+/* Backends of platform loop */
+enum class Backend : unsigned {
+    AUTO = 0,
+    SELECT = EVBACKEND_SELECT,
+    POLL = EVBACKEND_POLL,
+    EPOLL = EVBACKEND_EPOLL,
+    KQUEUE = EVBACKEND_KQUEUE,
+    DEVPOLL = EVBACKEND_DEVPOLL,
+    PORT = EVBACKEND_PORT,
+#if (EV_VERSION_MAJOR > 4) || (EV_VERSION_MINOR >= 31)
+    LINUXAIO = EVBACKEND_LINUXAIO,
+    IOURING = EVBACKEND_IOURING,
+#endif
+};
+
 /* Event handler */
 using OnEvent = std::function<void(int revents, void* payload)>;
 
@@ -29,32 +50,103 @@ using OnEvent = std::function<void(int revents, void* payload)>;
 class PlatformLoop : NonCopyable {
 
     template <typename A>
-    friend class Watcher;
+    friend class RawWatcher;
 
   public:
+    /* Options of platform loop */
+    struct Options {
+        /* Backend; `AUTO` lets libev choose the best one. */
+        Backend backend = Backend::AUTO;
+        /*
+         * Seconds to wait for more I/O events, or timeouts expiring close
+         * to each other, to handle them at one iteration; zero means no wait.
+         * It trades latency for fewer wakeups under bulk transfers.
+         */
+        double io_collect_interval = 0;
+        double timeout_collect_interval = 0;
+        /* Use signalfd on Linux for signal watching. */
+        bool signalfd = false;
+        /* Max number of events `EpollLoop` fetches at once; libev sizes and grows its buffer itself. */
+        size_t epoll_batch = 64;
+    };
+
     /* Return true if is running */
     bool running() const noexcept {
         return running_;
     }
 
+    /* Returns true if `backend` is supported by platform. */
+    static bool supported(Backend backend) noexcept {
+        return (backend == Backend::AUTO) || ((ev_supported_backends() & unsigned(backend)) != 0);
+    }
+
     /* Returns created pointer to new loop */
     static std::shared_ptr<PlatformLoop> createShared(int flag = EVFLAG_AUTO) {
         return std::shared_ptr<PlatformLoop>(new PlatformLoop(flag));
     }
 
+    /* Returns created pointer to new loop with given `options`. */
+    static std::shared_ptr<PlatformLoop> createShared(const Options& options) {
+        unsigned flag = unsigned(options.backend) | (options.signalfd ? EVFLAG_SIGNALFD : 0);
+        auto sp_loop = std::shared_ptr<PlatformLoop>(new PlatformLoop(int(flag)));
+        ev_set_io_collect_interval(sp_loop->raw, options.io_collect_interval);
+        ev_set_timeout_collect_interval(sp_loop->raw, options.timeout_collect_interval);
+        return sp_loop;
+    }
+
+    /* Returns backend in use. */
+    Backend backend() const noexcept {
+        return Backend(ev_backend(raw));
+    }
+
     /* Destructor. */
     ~PlatformLoop() {
         if (!ev_is_default_loop(raw))
             ev_loop_destroy(raw);
     }
 
-    /* Starts event dispatching. */
+    /* Returns number of loop iterations done. */
+    size_t iterations() const noexcept {
+        return size_t(ev_iteration(raw));
+    }
+
+    /* Starts event dispatching; it stays inside libev until stopped or nothing is watched. */
     void start() {
-        running_ = true;
-        while (running_) {
+        Running running(running_);
+        ev_run(raw, 0);
+    }
+
+    /* Dispatches events for `duration` at most; it returns earlier if stopped or nothing is watched. */
+    template <typename Rep, typename Period>
+    void runFor(const std::chrono::duration<Rep, Period>& duration) {
+        std::chrono::duration<double> seconds = duration;
+        ev_timer deadline;
+        ev_timer_init(&deadline, PlatformLoop::onDeadline, (seconds.count() > 0 ? seconds.count() : 0), 0.);
+        ev_now_update(raw);
+        ev_timer_start(raw, &deadline);
+        ev_unref(raw); // deadline alone does not keep loop running
+        // handler may throw out of `start`; deadline on stack is stopped anyway
+        struct Guard {
+            struct ev_loop* raw;
+            ev_timer* p_deadline;
+            ~Guard() {
+                ev_ref(raw);
+                ev_timer_stop(raw, p_deadline);
+            }
+        } guard{raw, &deadline};
+        start();
+    }
+
+    /* Runs `number` loop iterations at most; returns number of done ones. */
+    size_t runIterations(size_t number) {
+        size_t done = 0;
+        Running running(running_);
+        while (running_ && (done < number)) {
+            done++;
             if (!ev_run(raw, EVRUN_ONCE))
-                running_ = false;
+                break;
         }
+        return done;
     }
 
     /* Stops event dispatching. */
@@ -69,12 +161,31 @@ class PlatformLoop : NonCopyable {
     struct ev_loop* raw;
     bool running_ = false;
 
+    /* Sets running flag for its lifetime, so it is reset even if handler throws. */
+    struct Running {
+        bool& running;
+
+        Running(bool& running) noexcept : running(running) {
+            running = true;
+        }
+
+        ~Running() {
+            running = false;
+        }
+    };
+
+    static void onDeadline(struct ev_loop* p_loop, ev_timer* /* p_ev_watcher */, int /* revents */) {
+        ev_break(p_loop, EVBREAK_ONE);
+    }
+
     /* Constructor. */
     PlatformLoop(int flag) {
         if (flag == -1)
             raw = ev_default_loop(EVFLAG_AUTO);
         else
             raw = ev_loop_new(flag);
+        if (raw == nullptr)
+            throw exc::CannotSetupWatching("Cannot create event loop");
     }
 };
 } // squall::core
@@ -6,55 +6,79 @@ namespace squall {
 namespace core {
 
 
-/* Common event watcher */
+/*
+ * Raw event watcher; it does not know how events are handled.
+ * Derived class gives static `callback` which gets `ev` of this,
+ * and `ev` is the first member, so a pointer to it is a pointer to this.
+ */
 template <typename EV>
-class Watcher {
+class RawWatcher {
   protected:
     EV ev;
-    OnEvent on_event;
     struct ev_loop* p_loop;
 
-    static void callback(struct ev_loop* p_loop, EV* p_ev_watcher, int revents) {
-        auto p_watcher = reinterpret_cast<Watcher<EV>*>(p_ev_watcher);
-        p_watcher->on_event(revents, (void*)p_watcher);
+    using Callback = void (*)(struct ev_loop* p_loop, EV* p_ev_watcher, int revents);
+
+    /* Constructor */
+    RawWatcher(Callback callback, const std::shared_ptr<PlatformLoop>& sp_loop) : ev({}), p_loop(sp_loop->raw) {
+        ev_init(&ev, callback);
     }
 
+    /* Destructor */
+    ~RawWatcher() {}
+
   public:
     /* Return true if this is running. */
     bool running() const noexcept {
         return (ev_is_active(&ev) != 0);
     }
 
-    /* Constructor */
-    Watcher(OnEvent&& on_event, const std::shared_ptr<PlatformLoop>& sp_loop)
-        : ev({}), on_event(std::forward<OnEvent>(on_event)), p_loop(sp_loop->raw) {
-        ev_init(&ev, Watcher::callback);
-    }
-
-    /* Destructor */
-    ~Watcher() {}
-
     /* Sets up to starts an event watching. */
     template <typename... Args>
     bool setup(Args... args);
 
-    /* Cancels an event watching. */
+    /* Cancels an event watching and drops its pending events; returns true if it was running. */
     bool cancel();
+
+    /* Feeds `revents` to this watcher; they will be handled at the next loop iteration unless it is canceled. */
+    void feed(int revents) noexcept {
+        ev_feed_event(p_loop, &ev, revents);
+    }
 };
 
 
-template <>
-inline bool Watcher<ev_io>::cancel() {
-    if (running()) {
-        ev_io_stop(p_loop, &ev);
-        return true;
+/* Common event watcher */
+template <typename EV>
+class Watcher : public RawWatcher<EV> {
+  protected:
+    OnEvent on_event;
+
+    static void callback(struct ev_loop* p_loop, EV* p_ev_watcher, int revents) {
+        auto p_watcher = static_cast<Watcher<EV>*>(reinterpret_cast<RawWatcher<EV>*>(p_ev_watcher));
+        p_watcher->on_event(revents, (void*)p_watcher);
     }
-    return false;
+
+  public:
+    /* Constructor */
+    Watcher(OnEvent&& on_event, const std::shared_ptr<PlatformLoop>& sp_loop)
+        : RawWatcher<EV>(Watcher::callback, sp_loop), on_event(std::forward<OnEvent>(on_event)) {}
+
+    /* Destructor */
+    ~Watcher() {}
+};
+
+
+template <>
+inline bool RawWatcher<ev_io>::cancel() {
+    // stopping inactive watcher still drops its pending events, e.g. fed ones
+    auto was_running = running();
+    ev_io_stop(p_loop, &ev);
+    return was_running;
 }
 
 template <>
 template <>
-inline bool Watcher<ev_io>::setup<int, int>(int fd, int mode) {
+inline bool RawWatcher<ev_io>::setup<int, int>(int fd, int mode) {
     if (running())
         cancel();
     mode = (mode & (EV_READ | EV_WRITE));
@@ -68,17 +92,15 @@ inline bool Watcher<ev_io>::setup<int, int>(int fd, int mode) {
 
 
 template <>
-inline bool Watcher<ev_timer>::cancel() {
-    if (running()) {
-        ev_timer_stop(p_loop, &ev);
-        return true;
-    }
-    return false;
+inline bool RawWatcher<ev_timer>::cancel() {
+    auto was_running = running();
+    ev_timer_stop(p_loop, &ev);
+    return was_running;
 }
 
 template <>
 template <>
-inline bool Watcher<ev_timer>::setup<double, double>(double after, double repeat) {
+inline bool RawWatcher<ev_timer>::setup<double, double>(double after, double repeat) {
     if (running())
         cancel();
     if (after >= 0) {
@@ -91,17 +113,15 @@ inline bool Watcher<ev_timer>::setup<double, double>(double after, double repeat
 
 
 template <>
-inline bool Watcher<ev_signal>::cancel() {
-    if (running()) {
-        ev_signal_stop(p_loop, &ev);
-        return true;
-    }
-    return false;
+inline bool RawWatcher<ev_signal>::cancel() {
+    auto was_running = running();
+    ev_signal_stop(p_loop, &ev);
+    return was_running;
 }
 
 template <>
 template <>
-inline bool Watcher<ev_signal>::setup<int>(int signum) {
+inline bool RawWatcher<ev_signal>::setup<int>(int signum) {
     if (running())
         cancel();
     if (signum > 0) {
@@ -112,14 +132,139 @@ inline bool Watcher<ev_signal>::setup<int>(int signum) {
     return false;
 }
 
+template <>
+inline bool RawWatcher<ev_async>::cancel() {
+    auto was_running = running();
+    ev_async_stop(p_loop, &ev);
+    return was_running;
+}
+
+template <>
+template <>
+inline bool RawWatcher<ev_async>::setup<>() {
+    if (!running())
+        ev_async_start(p_loop, &ev);
+    return running();
+}
+
+template <>
+inline bool RawWatcher<ev_prepare>::cancel() {
+    auto was_running = running();
+    ev_prepare_stop(p_loop, &ev);
+    return was_running;
+}
+
+template <>
+template <>
+inline bool RawWatcher<ev_prepare>::setup<>() {
+    if (!running())
+        ev_prepare_start(p_loop, &ev);
+    return running();
+}
+
+template <>
+inline bool RawWatcher<ev_check>::cancel() {
+    auto was_running = running();
+    ev_check_stop(p_loop, &ev);
+    return was_running;
+}
+
+template <>
+template <>
+inline bool RawWatcher<ev_check>::setup<>() {
+    if (!running())
+        ev_check_start(p_loop, &ev);
+    return running();
+}
+
+template <>
+inline bool RawWatcher<ev_idle>::cancel() {
+    auto was_running = running();
+    ev_idle_stop(p_loop, &ev);
+    return was_running;
+}
+
+template <>
+template <>
+inline bool RawWatcher<ev_idle>::setup<>() {
+    if (!running())
+        ev_idle_start(p_loop, &ev);
+    return running();
+}
+
+
+/*
+ * Activity timeout which expires when it was not touched for given time.
+ * Touch only stores loop time; elapsed time is checked lazily
+ * when the platform timer fires, and the timer is re-armed
+ * for the rest of timeout with `ev_timer_again`.
+ */
+class ActivityTimer : public RawWatcher<ev_timer> {
+  public:
+    /* Returns timeout in seconds. */
+    double timeout() const noexcept {
+        return timeout_;
+    }
+
+    /* Starts watching with given timeout; restarts it if it is running. */
+    bool setup(double seconds) {
+        if (seconds <= 0)
+            return false;
+        timeout_ = seconds;
+        last_activity = ev_now(p_loop);
+        ev.repeat = seconds;
+        ev_timer_again(p_loop, &ev);
+        return running();
+    }
+
+    /* Marks activity; timeout is counted from now. */
+    void touch() noexcept {
+        last_activity = ev_now(p_loop);
+    }
+
+  protected:
+    /* Constructor */
+    ActivityTimer(Callback callback, const std::shared_ptr<PlatformLoop>& sp_loop)
+        : RawWatcher<ev_timer>(callback, sp_loop) {}
+
+    /* Called when timer fires; returns true if expired, else re-arms for the rest. */
+    bool expired() noexcept {
+        auto rest = last_activity + timeout_ - ev_now(p_loop);
+        if (rest > 0) {
+            ev.repeat = rest;
+            ev_timer_again(p_loop, &ev);
+            return false;
+        }
+        ev_timer_stop(p_loop, &ev);
+        return true;
+    }
+
+  private:
+    double timeout_ = 0, last_activity = 0;
+};
+
 using TimerWatcher = Watcher<ev_timer>;
 using SignalWatcher = Watcher<ev_signal>;
 
-class IoWatcher : public Watcher<ev_io> {
+/* Watchers called once per loop iteration: before polling, after polling and when there are no other events. */
+using PrepareWatcher = Watcher<ev_prepare>;
+using CheckWatcher = Watcher<ev_check>;
+using IdleWatcher = Watcher<ev_idle>;
 
-    template <typename T>
-    friend class Dispatcher;
+/* Async watcher; its `send` is the only method which may be called from other threads. */
+class AsyncWatcher : public Watcher<ev_async> {
+  public:
+    /* Constructor */
+    AsyncWatcher(OnEvent&& on_event, const std::shared_ptr<PlatformLoop>& sp_loop)
+        : Watcher<ev_async>(std::forward<OnEvent>(on_event), sp_loop) {}
+
+    /* Wakes up loop to call event handler; several sends before it may be coalesced. */
+    void send() noexcept {
+        ev_async_send(p_loop, &ev);
+    }
+};
 
+class IoWatcher : public Watcher<ev_io> {
   public:
     /* File descriptor */
     int fd() const noexcept {
@@ -0,0 +1,118 @@
+#ifndef SQUALL__CORE__SEARCH_HXX
+#define SQUALL__CORE__SEARCH_HXX
+#include <cstring>
+#include <cstddef>
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define SQUALL_SEARCH_X86 1
+#endif
+
+namespace squall {
+namespace core {
+
+
+/* Search function interface; returns found position or `end`. */
+using SearchFunc = const char* (*)(const char* begin, const char* end, const char* needle, size_t length);
+
+
+/* Scalar search; first byte candidates are filtered by `memchr`. */
+inline const char* searchScalar(const char* begin, const char* end, const char* needle, size_t length) noexcept {
+    if (length == 0)
+        return begin;
+    while (size_t(end - begin) >= length) {
+        auto found = static_cast<const char*>(std::memchr(begin, needle[0], end - begin - length + 1));
+        if (found == nullptr)
+            break;
+        if (std::memcmp(found + 1, needle + 1, length - 1) == 0)
+            return found;
+        begin = found + 1;
+    }
+    return end;
+}
+
+
+#if defined(SQUALL_SEARCH_X86) && defined(__SSE2__)
+/*
+ * SSE2 search; candidates are positions where both the first and
+ * the last byte of `needle` match, 16 positions per step.
+ */
+inline const char* searchSSE2(const char* begin, const char* end, const char* needle, size_t length) noexcept {
+    if (length < 2)
+        return searchScalar(begin, end, needle, length);
+    auto first = _mm_set1_epi8(needle[0]);
+    auto last = _mm_set1_epi8(needle[length - 1]);
+    auto pos = begin;
+    for (; size_t(end - pos) >= length - 1 + 16; pos += 16) {
+        auto block_first = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pos));
+        auto block_last = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pos + length - 1));
+        auto eq = _mm_and_si128(_mm_cmpeq_epi8(first, block_first), _mm_cmpeq_epi8(last, block_last));
+        unsigned mask = _mm_movemask_epi8(eq);
+        while (mask != 0) {
+            auto bit = __builtin_ctz(mask);
+            if (std::memcmp(pos + bit + 1, needle + 1, length - 2) == 0)
+                return pos + bit;
+            mask &= mask - 1;
+        }
+    }
+    return searchScalar(pos, end, needle, length);
+}
+#endif
+
+
+#if defined(SQUALL_SEARCH_X86)
+/* AVX2 search; same as `searchSSE2`, but 32 positions per step. */
+__attribute__((target("avx2"))) inline const char* searchAVX2(const char* begin, const char* end,
+                                                              const char* needle, size_t length) noexcept {
+    if (length < 2)
+        return searchScalar(begin, end, needle, length);
+    auto first = _mm256_set1_epi8(needle[0]);
+    auto last = _mm256_set1_epi8(needle[length - 1]);
+    auto pos = begin;
+    for (; size_t(end - pos) >= length - 1 + 32; pos += 32) {
+        auto block_first = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pos));
+        auto block_last = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pos + length - 1));
+        auto eq = _mm256_and_si256(_mm256_cmpeq_epi8(first, block_first), _mm256_cmpeq_epi8(last, block_last));
+        unsigned mask = _mm256_movemask_epi8(eq);
+        while (mask != 0) {
+            auto bit = __builtin_ctz(mask);
+            if (std::memcmp(pos + bit + 1, needle + 1, length - 2) == 0)
+                return pos + bit;
+            mask &= mask - 1;
+        }
+    }
+    return searchScalar(pos, end, needle, length);
+}
+#endif
+
+
+/* Returns the best search function supported by running CPU. */
+inline SearchFunc selectSearch() noexcept {
+#if defined(SQUALL_SEARCH_X86)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+        return searchAVX2;
+#if defined(__SSE2__)
+    return searchSSE2;
+#endif
+#endif
+    return searchScalar;
+}
+
+
+/*
+ * Returns pointer to the first occurrence of `needle` with given `length`
+ * in range from `begin` to `end` or `end` if it is not found.
+ * One-byte needles go to `memchr`, which is vectorized by libc;
+ * longer ones go to the SIMD search selected once at runtime.
+ */
+inline const char* searchBytes(const char* begin, const char* end, const char* needle, size_t length) noexcept {
+    static const SearchFunc search = selectSearch();
+    if (length == 1) {
+        auto found = static_cast<const char*>(std::memchr(begin, needle[0], end - begin));
+        return (found != nullptr) ? found : end;
+    }
+    return search(begin, end, needle, length);
+}
+} // squall::core
+} // squall
+#endif // SQUALL__CORE__SEARCH_HXX
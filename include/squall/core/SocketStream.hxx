@@ -0,0 +1,187 @@
+#ifndef SQUALL__CORE__SOCKET_STREAM_HXX
+#define SQUALL__CORE__SOCKET_STREAM_HXX
+#ifdef HAVE_UNISTD_H
+#include <memory>
+#include <cerrno>
+#include <unistd.h>
+#include <sys/socket.h>
+#include "Buffers.hxx"
+#include "NonCopyable.hxx"
+#include "PlatformLoop.hxx"
+#include "PlatformWatchers.hxx"
+
+namespace squall {
+namespace core {
+
+
+/*
+ * Connected stream socket which owns its fd, one I/O watcher and both buffers.
+ * Buffers only tell whether they want to read or write; watching mode is
+ * computed from both and applied once after an event is handled by both
+ * buffers, and only if it changed, so there is at most one watcher update
+ * per event. Outcoming buffer is write-through, so data written to it
+ * while it is empty is sent at once and WRITE is armed only for the rest.
+ * Buffer tasks are set up via `incoming()` and `outcoming()`; their
+ * handlers get pointer to the buffer as payload and may destroy the stream.
+ */
+class SocketStream : NonCopyable {
+  public:
+    /* Constructor; stream takes ownership of connected non-blocking socket `fd`. */
+    SocketStream(int fd, const std::shared_ptr<PlatformLoop>& sp_loop, size_t block_size = 4096,
+                 size_t max_size = 256 * 1024)
+        : fd_(fd), watcher(this, sp_loop), incoming_(this, block_size, max_size),
+          outcoming_(this, block_size, max_size) {
+        outcoming_.setWriteThrough(true);
+        outcoming_.stop(); // nothing to send yet
+        handling = false;
+        applyMode();
+    }
+
+    /* Destructor; closes socket. */
+    ~SocketStream() {
+        if (p_destroyed != nullptr)
+            *p_destroyed = true;
+        watcher.cancel();
+        incoming_.cleanup();
+        outcoming_.cleanup();
+        close(fd_);
+    }
+
+    /* File descriptor */
+    int fd() const noexcept {
+        return fd_;
+    }
+
+    /* Current watching mode */
+    int mode() const noexcept {
+        return mode_;
+    }
+
+    /* Returns number of watching mode changes applied. */
+    size_t updates() const noexcept {
+        return updates_;
+    }
+
+    /* Returns incoming buffer. */
+    IncomingBuffer& incoming() noexcept {
+        return incoming_;
+    }
+
+    /* Returns outcoming buffer. */
+    OutcomingBuffer& outcoming() noexcept {
+        return outcoming_;
+    }
+
+  private:
+    /* I/O watcher which calls stream directly. */
+    class Watcher : public RawWatcher<ev_io> {
+      public:
+        /* Constructor */
+        Watcher(SocketStream* p_stream, const std::shared_ptr<PlatformLoop>& sp_loop)
+            : RawWatcher<ev_io>(Watcher::callback, sp_loop), p_stream(p_stream) {}
+
+      private:
+        SocketStream* p_stream;
+
+        static void callback(struct ev_loop* p_loop, ev_io* p_ev_watcher, int revents) {
+            auto p_watcher = static_cast<Watcher*>(reinterpret_cast<RawWatcher<ev_io>*>(p_ev_watcher));
+            p_watcher->p_stream->onEvent(revents);
+        }
+    };
+
+    /* Incoming buffer which receives from socket by `recv`. */
+    class Incoming : public IncomingBuffer {
+      public:
+        /* Constructor */
+        Incoming(SocketStream* p_stream, size_t block_size, size_t max_size)
+            : IncomingBuffer(
+                  [p_stream](char* buff, size_t number) {
+                      auto received = recv(p_stream->fd_, buff, number, 0);
+                      if (received > 0)
+                          return std::make_pair(size_t(received), 0);
+                      return std::make_pair(size_t(0), (received == 0) ? 0 : errno);
+                  },
+                  [p_stream](bool resume) {
+                      p_stream->reading = resume;
+                      p_stream->applyMode();
+                      return true;
+                  },
+                  block_size, max_size) {}
+
+        using IncomingBuffer::operator();
+    };
+
+    /* Outcoming buffer which transmits to socket by `send`. */
+    class Outcoming : public OutcomingBuffer {
+      public:
+        /* Constructor */
+        Outcoming(SocketStream* p_stream, size_t block_size, size_t max_size)
+            : OutcomingBuffer(
+                  [p_stream](const char* buff, size_t number) {
+                      auto sent = send(p_stream->fd_, buff, number, MSG_NOSIGNAL);
+                      if (sent > 0)
+                          return std::make_pair(size_t(sent), 0);
+                      return std::make_pair(size_t(0), (sent == 0) ? 0 : errno);
+                  },
+                  [p_stream](bool resume) {
+                      p_stream->writing = resume;
+                      p_stream->applyMode();
+                      return true;
+                  },
+                  block_size, max_size) {}
+
+        /* Pauses flow; buffer resumes it when data is written. */
+        void stop() noexcept {
+            pause();
+        }
+
+        using OutcomingBuffer::operator();
+    };
+
+    int fd_;
+    int mode_ = 0;
+    size_t updates_ = 0;
+    bool reading = false, writing = false;
+    bool handling = true; // mode is applied once buffers are constructed
+    bool* p_destroyed = nullptr;
+    Watcher watcher;
+    Incoming incoming_;
+    Outcoming outcoming_;
+
+    /* Applies watching mode computed from buffers; it is deferred while an event is handled. */
+    void applyMode() {
+        if (handling)
+            return;
+        auto mode = (reading ? int(Event::READ) : 0) | (writing ? int(Event::WRITE) : 0);
+        if (mode != mode_) {
+            mode_ = mode;
+            updates_++;
+            if (mode != 0)
+                watcher.setup(fd_, mode);
+            else
+                watcher.cancel();
+        }
+    }
+
+    /* Passes event to buffers, then applies mode which they have changed; stops if a handler destroyed this. */
+    void onEvent(int revents) {
+        bool destroyed = false;
+        p_destroyed = &destroyed;
+        handling = true;
+        if (revents & (Event::WRITE | Event::ERROR))
+            outcoming_((revents & Event::ERROR) ? int(Event::ERROR) : int(Event::WRITE));
+        if (destroyed)
+            return;
+        if (revents & (Event::READ | Event::ERROR))
+            incoming_((revents & Event::ERROR) ? int(Event::ERROR) : int(Event::READ));
+        if (destroyed)
+            return;
+        handling = false;
+        p_destroyed = nullptr;
+        applyMode();
+    }
+};
+} // squall::core
+} // squall
+#endif // HAVE_UNISTD_H
+#endif // SQUALL__CORE__SOCKET_STREAM_HXX
@@ -0,0 +1,79 @@
+#ifndef SQUALL__CORE__SOCKETS_HXX
+#define SQUALL__CORE__SOCKETS_HXX
+#ifdef HAVE_UNISTD_H
+#include <string>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <netdb.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include "Exceptions.hxx"
+
+namespace squall {
+namespace core {
+
+
+/* Returns true if the platform lets several sockets listen the same port. */
+inline bool reusePortSupported() noexcept {
+#ifdef SO_REUSEPORT
+    return true;
+#else
+    return false;
+#endif
+}
+
+
+/*
+ * Returns non-blocking socket listening `host` and `port`.
+ * With `reuse_port` each loop of a group may listen own socket
+ * on the same port, then the kernel balances connections among them.
+ */
+inline int listenSocket(const std::string& host, unsigned short port, bool reuse_port = true,
+                        int backlog = SOMAXCONN) {
+    struct addrinfo hints;
+    std::memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_flags = AI_PASSIVE | AI_NUMERICSERV;
+    struct addrinfo* p_info = nullptr;
+    auto service = std::to_string(port);
+    auto result = getaddrinfo(host.size() ? host.c_str() : nullptr, service.c_str(), &hints, &p_info);
+    if (result != 0)
+        throw exc::CannotListen(std::string("Cannot resolve address: ") + gai_strerror(result));
+
+    int error = 0;
+    for (auto p_addr = p_info; p_addr != nullptr; p_addr = p_addr->ai_next) {
+        int fd = socket(p_addr->ai_family, p_addr->ai_socktype, p_addr->ai_protocol);
+        if (fd < 0) {
+            error = errno;
+            continue;
+        }
+        int on = 1;
+        bool ok = (setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on)) == 0);
+#ifdef SO_REUSEPORT
+        if (ok && reuse_port)
+            ok = (setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &on, sizeof(on)) == 0);
+#else
+        if (ok && reuse_port) {
+            ok = false;
+            errno = ENOPROTOOPT;
+        }
+#endif
+        ok = ok && (fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK) == 0);
+        ok = ok && (bind(fd, p_addr->ai_addr, p_addr->ai_addrlen) == 0);
+        ok = ok && (listen(fd, backlog) == 0);
+        if (ok) {
+            freeaddrinfo(p_info);
+            return fd;
+        }
+        error = errno;
+        close(fd);
+    }
+    freeaddrinfo(p_info);
+    throw exc::CannotListen(std::string("Cannot listen a socket: ") + std::strerror(error));
+}
+} // squall::core
+} // squall
+#endif // HAVE_UNISTD_H
+#endif // SQUALL__CORE__SOCKETS_HXX
@@ -0,0 +1,129 @@
+#ifndef SQUALL__CORE__TASK_QUEUE_HXX
+#define SQUALL__CORE__TASK_QUEUE_HXX
+#include <atomic>
+#include <memory>
+#include <functional>
+#include "NonCopyable.hxx"
+#include "PlatformLoop.hxx"
+#include "PlatformWatchers.hxx"
+
+namespace squall {
+namespace core {
+
+
+/*
+ * Queue of tasks posted from any thread to run on the loop thread.
+ * It is a lock-free multi-producer single-consumer queue; only the first
+ * post after a drain wakes up loop, so a burst of posts costs one wakeup.
+ * Methods except `post` must be called from the loop thread.
+ */
+class TaskQueue : NonCopyable {
+  public:
+    using Task = std::function<void()>;
+
+    /* Returns created pointer to new queue; `max_batch` limits tasks run per wakeup, zero means no limit. */
+    static std::shared_ptr<TaskQueue> createShared(const std::shared_ptr<PlatformLoop>& sp_loop, size_t max_batch = 0) {
+        return std::shared_ptr<TaskQueue>(new TaskQueue(sp_loop, max_batch));
+    }
+
+    /* Destructor; drops not run tasks. */
+    ~TaskQueue() {
+        watcher.cancel();
+        while (auto p_node = pop())
+            delete p_node;
+    }
+
+    /* Returns number of wakeups handled. */
+    size_t wakeups() const noexcept {
+        return wakeups_;
+    }
+
+    /* Posts `task` to run on the loop thread; thread safe. */
+    void post(Task&& task) {
+        push(new Node(std::forward<Task>(task)));
+        if (!pending.exchange(true, std::memory_order_acq_rel))
+            watcher.send();
+    }
+
+  private:
+    struct Node {
+        std::atomic<Node*> next;
+        Task task;
+
+        Node() : next(nullptr) {}
+        Node(Task&& task) : next(nullptr), task(std::forward<Task>(task)) {}
+    };
+
+    std::shared_ptr<PlatformLoop> sp_loop;
+    AsyncWatcher watcher;
+    size_t max_batch, wakeups_ = 0;
+    std::atomic<bool> pending;
+    std::atomic<Node*> head; // producers side
+    Node* tail;              // consumer side
+    Node stub;
+
+    /* Runs posted tasks; returns number of them. It is called by loop on wakeup. */
+    size_t drain() {
+        // RMW synchronizes with the last producer which found queue not pending
+        pending.exchange(false, std::memory_order_acq_rel);
+        size_t done = 0;
+        while ((max_batch == 0) || (done < max_batch)) {
+            auto p_node = pop();
+            if (p_node == nullptr)
+                return done;
+            std::unique_ptr<Node> up_node(p_node);
+            done++;
+            up_node->task();
+        }
+        // batch limit is reached; the rest runs at the next loop iteration
+        if (!pending.exchange(true, std::memory_order_acq_rel))
+            watcher.send();
+        return done;
+    }
+
+    /* Constructor */
+    TaskQueue(const std::shared_ptr<PlatformLoop>& sp_loop, size_t max_batch)
+        : sp_loop(sp_loop),
+          watcher([this](int revents, void* payload) {
+              wakeups_++;
+              drain();
+          }, sp_loop),
+          max_batch(max_batch), pending(false), head(&stub), tail(&stub) {
+        watcher.setup();
+    }
+
+    /* Appends `p_node`; wait-free for producers. */
+    void push(Node* p_node) noexcept {
+        p_node->next.store(nullptr, std::memory_order_relaxed);
+        auto p_prev = head.exchange(p_node, std::memory_order_acq_rel);
+        p_prev->next.store(p_node, std::memory_order_release);
+    }
+
+    /* Returns the first node or nullptr; a node being pushed right now may be not seen. */
+    Node* pop() noexcept {
+        auto p_tail = tail;
+        auto p_next = p_tail->next.load(std::memory_order_acquire);
+        if (p_tail == &stub) {
+            if (p_next == nullptr)
+                return nullptr;
+            tail = p_tail = p_next;
+            p_next = p_next->next.load(std::memory_order_acquire);
+        }
+        if (p_next != nullptr) {
+            tail = p_next;
+            return p_tail;
+        }
+        if (p_tail != head.load(std::memory_order_acquire))
+            return nullptr; // producer is between exchange and link; it will wake up loop
+        push(&stub);
+        p_next = p_tail->next.load(std::memory_order_acquire);
+        if (p_next != nullptr) {
+            tail = p_next;
+            return p_tail;
+        }
+        return nullptr;
+    }
+};
+} // squall::core
+} // squall
+#endif // SQUALL__CORE__TASK_QUEUE_HXX
@@ -0,0 +1,150 @@
+#ifndef SQUALL__CORE__THREAD_POOL_HXX
+#define SQUALL__CORE__THREAD_POOL_HXX
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <stdexcept>
+#include <functional>
+#include <condition_variable>
+#include "NonCopyable.hxx"
+
+namespace squall {
+namespace core {
+
+
+/*
+ * Work-stealing pool of threads for CPU-heavy tasks.
+ * Each worker has own deque: it takes own tasks from the back and
+ * steals tasks of others from the front when it runs out of work.
+ * Tasks submitted from a worker go to its own deque; tasks submitted
+ * from other threads are spread among workers in round-robin order.
+ * Exceptions of tasks are swallowed; `Offload` passes them to loop.
+ */
+class ThreadPool : NonCopyable {
+  public:
+    using Task = std::function<void()>;
+
+    /* Returns created pointer to new pool of `size` threads; zero means a thread per core but one. */
+    static std::shared_ptr<ThreadPool> createShared(size_t size = 0) {
+        return std::shared_ptr<ThreadPool>(new ThreadPool(size));
+    }
+
+    /* Destructor */
+    ~ThreadPool() {
+        shutdown();
+    }
+
+    /* Returns number of threads. */
+    size_t size() const noexcept {
+        return workers.size();
+    }
+
+    /* Submits `task`; thread safe. Once pool is shut down, only its own tasks may submit. */
+    void submit(Task&& task) {
+        auto& current = currentWorker();
+        auto index = (current.first == this) ? current.second : (next++ % workers.size());
+        {
+            // counted before pushed, so shutdown waits for it
+            std::lock_guard<std::mutex> lock(idle_mutex);
+            if (stopping && (current.first != this))
+                throw std::runtime_error("Thread pool is shut down");
+            queued++;
+        }
+        {
+            std::lock_guard<std::mutex> lock(workers[index]->mutex);
+            workers[index]->tasks.push_back(std::forward<Task>(task));
+        }
+        idle.notify_one();
+    }
+
+    /* Runs already submitted tasks and joins threads. */
+    void shutdown() {
+        {
+            std::lock_guard<std::mutex> lock(idle_mutex);
+            if (stopping)
+                return;
+            stopping = true;
+        }
+        idle.notify_all();
+        for (auto& up_worker : workers)
+            if (up_worker->thread.joinable())
+                up_worker->thread.join();
+    }
+
+  private:
+    struct Worker {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+        std::thread thread;
+    };
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::atomic<size_t> next, queued;
+    bool stopping;
+    std::mutex idle_mutex;
+    std::condition_variable idle;
+
+    /* Constructor */
+    ThreadPool(size_t size) : next(0), queued(0), stopping(false) {
+        if (size == 0) {
+            auto cores = std::thread::hardware_concurrency();
+            size = (cores > 1) ? cores - 1 : 1;
+        }
+        for (size_t index = 0; index < size; index++)
+            workers.emplace_back(new Worker());
+        for (size_t index = 0; index < size; index++)
+            workers[index]->thread = std::thread(&ThreadPool::run, this, index);
+    }
+
+    /* Returns pool and index of worker running on current thread. */
+    static std::pair<ThreadPool*, size_t>& currentWorker() noexcept {
+        static thread_local std::pair<ThreadPool*, size_t> current(nullptr, 0);
+        return current;
+    }
+
+    /* Takes task from the back of own deque or from the front of others. */
+    bool take(size_t index, Task& task) {
+        for (size_t i = 0; i < workers.size(); i++) {
+            auto& worker = *workers[(index + i) % workers.size()];
+            std::lock_guard<std::mutex> lock(worker.mutex);
+            if (!worker.tasks.empty()) {
+                if (i == 0) {
+                    task = std::move(worker.tasks.back());
+                    worker.tasks.pop_back();
+                } else {
+                    task = std::move(worker.tasks.front());
+                    worker.tasks.pop_front();
+                }
+                queued--;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /* Thread body */
+    void run(size_t index) {
+        currentWorker() = std::make_pair(this, index);
+        Task task;
+        while (true) {
+            if (take(index, task)) {
+                try {
+                    task();
+                } catch (...) {
+                }
+                task = nullptr;
+                continue;
+            }
+            std::unique_lock<std::mutex> lock(idle_mutex);
+            idle.wait(lock, [this]() { return stopping || (queued > 0); });
+            if (stopping && (queued == 0))
+                return;
+        }
+    }
+};
+} // squall::core
+} // squall
+#endif // SQUALL__CORE__THREAD_POOL_HXX
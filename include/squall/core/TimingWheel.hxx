@@ -0,0 +1,247 @@
+#ifndef SQUALL__CORE__TIMING_WHEEL_HXX
+#define SQUALL__CORE__TIMING_WHEEL_HXX
+#include <cmath>
+#include <memory>
+#include <cstdint>
+#include "NonCopyable.hxx"
+#include "PlatformLoop.hxx"
+#include "PlatformWatchers.hxx"
+
+namespace squall {
+namespace core {
+
+
+/*
+ * Hierarchical timing wheel driven by a single platform timer.
+ * Timeouts are rounded up to ticks of given resolution; arm, re-arm and
+ * cancel are O(1) operations on intrusive lists. Level `n` has 256 slots
+ * of 256^n ticks; timeouts are moved to lower levels as time goes by.
+ * The platform timer runs only while there are armed timeouts.
+ */
+class TimingWheel : NonCopyable {
+    /* Link of intrusive circular list; plain one is a list head. */
+    struct Link {
+        Link* prev = nullptr;
+        Link* next = nullptr;
+
+        /* Makes this empty list head. */
+        void reset() noexcept {
+            prev = next = this;
+        }
+
+        /* Inserts this before `p_head` of circular list. */
+        void link(Link* p_head) noexcept {
+            prev = p_head->prev;
+            next = p_head;
+            prev->next = this;
+            p_head->prev = this;
+        }
+
+        /* Removes this from list. */
+        void unlink() noexcept {
+            if (prev != nullptr) {
+                prev->next = next;
+                next->prev = prev;
+                prev = next = nullptr;
+            }
+        }
+    };
+
+  public:
+    /* Intrusive timeout; derived class gives `callback` called on expiration. */
+    class Node : Link, NonCopyable {
+        friend class TimingWheel;
+
+      public:
+        using Callback = void (*)(Node* p_node);
+
+        /* Constructor */
+        Node(Callback callback) noexcept : callback(callback) {}
+
+        /* Destructor; cancels armed node. */
+        ~Node() {
+            if (armed() && (p_wheel != nullptr))
+                p_wheel->cancel(this);
+            else
+                unlink();
+        }
+
+        /* Returns true if this is armed. */
+        bool armed() const noexcept {
+            return (prev != nullptr);
+        }
+
+      private:
+        TimingWheel* p_wheel = nullptr;
+        uint64_t expires = 0;
+        Callback callback;
+    };
+
+    /* Returns valid tick resolution for given one. */
+    static double validResolution(double resolution) noexcept {
+        return (resolution > 0) ? resolution : 0.001;
+    }
+
+    /* Constructor */
+    TimingWheel(const std::shared_ptr<PlatformLoop>& sp_loop, double resolution = 0.1)
+        : ticker(this, sp_loop), resolution_(validResolution(resolution)), origin(ticker.now()) {
+        for (auto& level : slots)
+            for (auto& head : level)
+                head.reset();
+    }
+
+    /* Destructor */
+    ~TimingWheel() {
+        clear();
+    }
+
+    /* Returns tick resolution in seconds. */
+    double resolution() const noexcept {
+        return resolution_;
+    }
+
+    /* Returns number of armed timeouts. */
+    size_t size() const noexcept {
+        return count;
+    }
+
+    /*
+     * Arms or re-arms `p_node` to expire after `seconds` rounded up to ticks,
+     * at least one. Expiration is counted from the end of the current tick,
+     * so timeout never expires early, but may expire up to two ticks late.
+     */
+    void arm(Node* p_node, double seconds) {
+        if (p_node->armed()) {
+            p_node->unlink();
+            count--;
+        }
+        auto now = nowTick(ev_time()); // loop time may be stale here
+        if (count == 0) {
+            current = (now > current) ? now : current; // nothing to expire in skipped ticks
+            if (!ticker.running())
+                ticker.setup(resolution_, resolution_);
+        }
+        double ticks = std::ceil(seconds / resolution_);
+        ticks = (ticks >= 1) ? ticks : 1;
+        ticks = (ticks < double(MAX_TICKS)) ? ticks : double(MAX_TICKS);
+        p_node->expires = ((now > current) ? now : current) + 1 + uint64_t(ticks);
+        p_node->p_wheel = this;
+        insert(p_node);
+        count++;
+    }
+
+    /* Cancels `p_node`; returns false if it was not armed. */
+    bool cancel(Node* p_node) noexcept {
+        if (!p_node->armed())
+            return false;
+        p_node->unlink();
+        if (--count == 0)
+            ticker.cancel();
+        return true;
+    }
+
+    /* Cancels all armed timeouts and stops the platform timer. */
+    void clear() noexcept {
+        for (auto& level : slots)
+            for (auto& head : level)
+                while (head.next != &head)
+                    head.next->unlink();
+        count = 0;
+        ticker.cancel();
+    }
+
+  private:
+    static const int LEVELS = 4;
+    static const int SLOT_BITS = 8;
+    static const uint64_t SLOTS = uint64_t(1) << SLOT_BITS;
+    static const uint64_t MAX_TICKS = (uint64_t(1) << (LEVELS * SLOT_BITS)) - 1;
+
+    /* Platform timer which advances wheel. */
+    class Ticker : public RawWatcher<ev_timer> {
+      public:
+        /* Constructor */
+        Ticker(TimingWheel* p_wheel, const std::shared_ptr<PlatformLoop>& sp_loop)
+            : RawWatcher<ev_timer>(Ticker::callback, sp_loop), p_wheel(p_wheel) {}
+
+        /* Returns loop time. */
+        double now() const noexcept {
+            return ev_now(p_loop);
+        }
+
+      private:
+        TimingWheel* p_wheel;
+
+        static void callback(struct ev_loop* /* p_loop */, ev_timer* p_ev_watcher, int /* revents */) {
+            auto p_ticker = static_cast<Ticker*>(reinterpret_cast<RawWatcher<ev_timer>*>(p_ev_watcher));
+            p_ticker->p_wheel->advance();
+        }
+    };
+
+    Link slots[LEVELS][SLOTS];
+    Ticker ticker;
+    double resolution_, origin;
+    uint64_t current = 0;
+    size_t count = 0;
+
+    /* Returns number of the tick which is going at `time`. */
+    uint64_t nowTick(double time) const noexcept {
+        auto elapsed = (time - origin) / resolution_;
+        return (elapsed > 0) ? uint64_t(elapsed) : 0;
+    }
+
+    /* Inserts `p_node` to slot by its remaining ticks. */
+    void insert(Node* p_node) noexcept {
+        auto delta = p_node->expires - current;
+        int level = 0;
+        while ((level < LEVELS - 1) && (delta >= (uint64_t(1) << ((level + 1) * SLOT_BITS))))
+            level++;
+        p_node->link(&slots[level][(p_node->expires >> (level * SLOT_BITS)) & (SLOTS - 1)]);
+    }
+
+    /* Processes ticks up to now. */
+    void advance() {
+        auto now = nowTick(ticker.now());
+        while ((current < now) && (count > 0)) {
+            current++;
+            // moves timeouts of the next span of upper level to lower ones
+            for (int level = 1; level < LEVELS; level++) {
+                if ((current & ((uint64_t(1) << (level * SLOT_BITS)) - 1)) != 0)
+                    break;
+                Link list;
+                splice(&slots[level][(current >> (level * SLOT_BITS)) & (SLOTS - 1)], &list);
+                while (list.next != &list) {
+                    auto p_node = static_cast<Node*>(list.next);
+                    p_node->unlink();
+                    insert(p_node);
+                }
+            }
+            // detached list lets callbacks cancel or re-arm any timeout
+            Link list;
+            splice(&slots[0][current & (SLOTS - 1)], &list);
+            while (list.next != &list) {
+                auto p_node = static_cast<Node*>(list.next);
+                p_node->unlink();
+                count--;
+                p_node->callback(p_node);
+            }
+        }
+        if (count == 0)
+            ticker.cancel();
+    }
+
+    /* Moves all nodes from list `p_from` to empty list `p_to`. */
+    static void splice(Link* p_from, Link* p_to) noexcept {
+        if (p_from->next == p_from) {
+            p_to->reset();
+        } else {
+            p_to->next = p_from->next;
+            p_to->prev = p_from->prev;
+            p_to->next->prev = p_to;
+            p_to->prev->next = p_to;
+            p_from->reset();
+        }
+    }
+};
+} // squall::core
+} // squall
+#endif // SQUALL__CORE__TIMING_WHEEL_HXX
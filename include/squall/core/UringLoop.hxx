@@ -0,0 +1,487 @@
+#ifndef SQUALL__CORE__URING_LOOP_HXX
+#define SQUALL__CORE__URING_LOOP_HXX
+#ifdef HAVE_IO_URING_H
+#include <deque>
+#include <memory>
+#include <vector>
+#include <cerrno>
+#include <cstring>
+#include <cstdint>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+#include "Exceptions.hxx"
+#include "NonCopyable.hxx"
+#include "PlatformLoop.hxx"
+
+namespace squall {
+namespace core {
+
+class UringStream;
+
+
+/*
+ * Completion-based I/O loop on io_uring; Linux 5.19 or newer.
+ * Streams submit receives and sends, which are passed to the kernel
+ * together with waiting for completions, so one `io_uring_enter`
+ * serves many requests. Received data lands in a ring of buffers
+ * provided to the kernel, and one multishot receive keeps a stream
+ * receiving. It uses raw syscalls, so no library is needed; if
+ * `supported` returns false, use `PlatformLoop` with buffers instead.
+ */
+class UringLoop : NonCopyable {
+    friend class UringStream;
+
+  public:
+    /* Received data; it is valid only during the event handler call. */
+    struct Chunk {
+        const char* data;
+        size_t size;
+    };
+
+    /* Returns true if the running kernel provides all that this loop needs. */
+    static bool supported() noexcept {
+        try {
+            createShared(2, 1, 64);
+            return true;
+        } catch (const exc::CannotSetupWatching&) {
+            return false;
+        }
+    }
+
+    /* Return true if is running */
+    bool running() const noexcept {
+        return running_;
+    }
+
+    /* Returns number of `io_uring_enter` syscalls made. */
+    size_t enters() const noexcept {
+        return enters_;
+    }
+
+    /* Returns true if receives are multishot; they are re-armed one by one on older kernels. */
+    bool multishot() const noexcept {
+        return multishot_;
+    }
+
+    /*
+     * Returns created pointer to new loop with `entries` submission slots
+     * and `buffers` of `buffer_size` bytes provided for receiving; `buffers`
+     * is rounded up to a power of two. Throws `exc::CannotSetupWatching`
+     * if io_uring is not available.
+     */
+    static std::shared_ptr<UringLoop> createShared(unsigned entries = 256, unsigned buffers = 256,
+                                                   unsigned buffer_size = 4096) {
+        return std::shared_ptr<UringLoop>(new UringLoop(entries, buffers, buffer_size));
+    }
+
+    /* Destructor; streams are to be destroyed before. */
+    ~UringLoop() {
+        close(ring_fd);
+        release();
+    }
+
+    /* Starts event dispatching; it returns when stopped or nothing is in flight. */
+    void start() {
+        running_ = true;
+        while (running_) {
+            if (!runOnce(true))
+                running_ = false;
+        }
+    }
+
+    /* Stops event dispatching; completions already reaped are handled. */
+    void stop() noexcept {
+        running_ = false;
+    }
+
+    /* Submits prepared requests and handles completions, waiting for one if `wait`; returns false if nothing is in flight. */
+    bool runOnce(bool wait = false);
+
+  private:
+    static const uint16_t BUFFER_GROUP = 0;
+
+    /* Request of stream; it outlives stream destroyed while request is in flight. */
+    struct Slot {
+        UringStream* p_stream = nullptr;
+        bool receive = false, in_flight = false;
+        std::vector<char> data; // bytes being sent
+        Slot* p_next_free = nullptr;
+    };
+
+    int ring_fd = -1;
+    bool running_ = false, multishot_ = true;
+    size_t enters_ = 0, in_flight = 0;
+    unsigned sq_tail = 0, sq_submitted = 0;
+    unsigned *sq_head_ptr, *sq_tail_ptr, *sq_array, sq_mask, sq_entries;
+    unsigned *cq_head_ptr, *cq_tail_ptr, cq_mask;
+    struct io_uring_cqe* cqes;
+    struct io_uring_sqe* sqes = nullptr;
+    void *p_sq_ring = nullptr, *p_cq_ring = nullptr;
+    size_t sq_ring_size = 0, cq_ring_size = 0, sqes_size = 0;
+    struct io_uring_buf* p_bufs = nullptr;
+    size_t buf_ring_size = 0;
+    unsigned buf_mask = 0, buffer_size;
+    uint16_t buf_tail = 0;
+    std::vector<char> buffers;
+    std::deque<Slot> slots;
+    Slot* p_free_slots = nullptr;
+
+    /* Constructor. */
+    UringLoop(unsigned entries, unsigned buffer_count, unsigned buffer_size) : buffer_size(buffer_size) {
+        struct io_uring_params params;
+        std::memset(&params, 0, sizeof(params));
+        ring_fd = int(syscall(__NR_io_uring_setup, entries, &params));
+        if (ring_fd < 0)
+            throw exc::CannotSetupWatching("Cannot setup io_uring");
+        try {
+            map(params);
+            provideBuffers(buffer_count);
+        } catch (...) {
+            close(ring_fd);
+            release();
+            throw;
+        }
+    }
+
+    /* Maps rings shared with the kernel. */
+    void map(const struct io_uring_params& params) {
+        sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+        if (params.features & IORING_FEAT_SINGLE_MMAP)
+            sq_ring_size = cq_ring_size = (sq_ring_size > cq_ring_size) ? sq_ring_size : cq_ring_size;
+        p_sq_ring = mapRing(sq_ring_size, IORING_OFF_SQ_RING);
+        p_cq_ring = (params.features & IORING_FEAT_SINGLE_MMAP) ? p_sq_ring : mapRing(cq_ring_size, IORING_OFF_CQ_RING);
+        sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+        sqes = static_cast<struct io_uring_sqe*>(mapRing(sqes_size, IORING_OFF_SQES));
+
+        auto sq = static_cast<char*>(p_sq_ring);
+        sq_head_ptr = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+        sq_tail_ptr = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+        sq_array = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+        sq_mask = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+        sq_entries = params.sq_entries;
+        sq_tail = sq_submitted = *sq_tail_ptr;
+
+        auto cq = static_cast<char*>(p_cq_ring);
+        cq_head_ptr = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+        cq_tail_ptr = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+        cq_mask = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+        cqes = reinterpret_cast<struct io_uring_cqe*>(cq + params.cq_off.cqes);
+    }
+
+    void* mapRing(size_t size, uint64_t offset) {
+        auto p_ring = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, offset);
+        if (p_ring == MAP_FAILED)
+            throw exc::CannotSetupWatching("Cannot map io_uring");
+        return p_ring;
+    }
+
+    /* Registers ring of buffers which the kernel picks for received data. */
+    void provideBuffers(unsigned count) {
+        unsigned entries = 1;
+        while (entries < count)
+            entries <<= 1;
+        buf_ring_size = entries * sizeof(struct io_uring_buf);
+        auto p_ring = mmap(nullptr, buf_ring_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (p_ring == MAP_FAILED) {
+            buf_ring_size = 0;
+            throw exc::CannotSetupWatching("Cannot allocate io_uring buffers");
+        }
+        // ring is an array of buffers which tail overlays `resv` of the first one;
+        // `io_uring_buf_ring` is not used as its flexible array is laid out differently in C++
+        p_bufs = static_cast<struct io_uring_buf*>(p_ring);
+        buf_mask = entries - 1;
+
+        struct io_uring_buf_reg reg;
+        std::memset(&reg, 0, sizeof(reg));
+        reg.ring_addr = reinterpret_cast<uint64_t>(p_bufs);
+        reg.ring_entries = entries;
+        reg.bgid = BUFFER_GROUP;
+        if (syscall(__NR_io_uring_register, ring_fd, IORING_REGISTER_PBUF_RING, &reg, 1) != 0)
+            throw exc::CannotSetupWatching("Cannot register io_uring buffers");
+        buffers.resize(size_t(entries) * buffer_size);
+        for (unsigned bid = 0; bid < entries; bid++)
+            recycle(uint16_t(bid));
+    }
+
+    /* Unmaps shared memory. */
+    void release() noexcept {
+        if (p_bufs != nullptr)
+            munmap(p_bufs, buf_ring_size);
+        if (sqes != nullptr)
+            munmap(sqes, sqes_size);
+        if ((p_cq_ring != nullptr) && (p_cq_ring != p_sq_ring))
+            munmap(p_cq_ring, cq_ring_size);
+        if (p_sq_ring != nullptr)
+            munmap(p_sq_ring, sq_ring_size);
+    }
+
+    /* Returns buffer `bid` to the kernel. */
+    void recycle(uint16_t bid) noexcept {
+        auto& buf = p_bufs[buf_tail & buf_mask];
+        buf.addr = reinterpret_cast<uint64_t>(buffers.data() + size_t(bid) * buffer_size);
+        buf.len = buffer_size;
+        buf.bid = bid;
+        __atomic_store_n(&p_bufs[0].resv, ++buf_tail, __ATOMIC_RELEASE);
+    }
+
+    /* Returns free slot for `p_stream`. */
+    Slot* acquireSlot(UringStream* p_stream, bool receive) {
+        Slot* p_slot = p_free_slots;
+        if (p_slot != nullptr) {
+            p_free_slots = p_slot->p_next_free;
+        } else {
+            slots.emplace_back();
+            p_slot = &slots.back();
+        }
+        p_slot->p_stream = p_stream;
+        p_slot->receive = receive;
+        return p_slot;
+    }
+
+    /* Releases slot of destroyed stream; request in flight is canceled, then slot is freed on its completion. */
+    void releaseSlot(Slot* p_slot) {
+        p_slot->p_stream = nullptr;
+        if (p_slot->in_flight) {
+            auto p_sqe = prepare(nullptr);
+            p_sqe->opcode = IORING_OP_ASYNC_CANCEL;
+            p_sqe->addr = reinterpret_cast<uint64_t>(p_slot);
+        } else
+            freeSlot(p_slot);
+    }
+
+    void freeSlot(Slot* p_slot) noexcept {
+        p_slot->data.clear();
+        p_slot->p_next_free = p_free_slots;
+        p_free_slots = p_slot;
+    }
+
+    /* Returns cleared submission entry for request of `p_slot`; it is passed to the kernel by `runOnce`. */
+    struct io_uring_sqe* prepare(Slot* p_slot) {
+        if (sq_tail - __atomic_load_n(sq_head_ptr, __ATOMIC_ACQUIRE) >= sq_entries) {
+            enter(0); // queue is full, so it is passed right now
+            if (sq_tail - __atomic_load_n(sq_head_ptr, __ATOMIC_ACQUIRE) >= sq_entries)
+                throw exc::CannotSetupWatching("io_uring submission queue is full");
+        }
+        auto index = sq_tail & sq_mask;
+        auto p_sqe = &sqes[index];
+        std::memset(p_sqe, 0, sizeof(*p_sqe));
+        p_sqe->user_data = reinterpret_cast<uint64_t>(p_slot);
+        sq_array[index] = index;
+        sq_tail++;
+        if (p_slot != nullptr) {
+            p_slot->in_flight = true;
+            in_flight++;
+        }
+        return p_sqe;
+    }
+
+    /* Passes prepared requests to the kernel and waits for `min_complete` completions. */
+    void enter(unsigned min_complete) {
+        __atomic_store_n(sq_tail_ptr, sq_tail, __ATOMIC_RELEASE);
+        auto to_submit = sq_tail - sq_submitted;
+        enters_++;
+        auto result = syscall(__NR_io_uring_enter, ring_fd, to_submit, min_complete,
+                              (min_complete > 0) ? IORING_ENTER_GETEVENTS : 0, nullptr, 0);
+        if (result > 0)
+            sq_submitted += unsigned(result);
+        else if ((result < 0) && (errno != EINTR) && (errno != EBUSY) && (errno != EAGAIN))
+            throw exc::CannotSetupWatching("Cannot submit io_uring requests");
+    }
+};
+
+
+/*
+ * Stream socket on `UringLoop`. Once set up, it receives data continuously
+ * and calls handler with `Event::READ` and pointer to `UringLoop::Chunk`;
+ * empty chunk means end of stream. Written data is sent in order; when all
+ * is sent, handler is called with `Event::WRITE`. On failure handler gets
+ * `Event::ERROR` together with the failed direction, and that direction stops.
+ */
+class UringStream : NonCopyable {
+    friend class UringLoop;
+
+  public:
+    /* Constructor */
+    UringStream(OnEvent&& on_event, const std::shared_ptr<UringLoop>& sp_loop)
+        : on_event(std::forward<OnEvent>(on_event)), p_loop(sp_loop.get()),
+          p_recv(p_loop->acquireSlot(this, true)), p_send(p_loop->acquireSlot(this, false)) {}
+
+    /* Destructor */
+    ~UringStream() {
+        p_loop->releaseSlot(p_recv);
+        p_loop->releaseSlot(p_send);
+    }
+
+    /* Return true if this is receiving. */
+    bool running() const noexcept {
+        return receiving;
+    }
+
+    /* File descriptor */
+    int fd() const noexcept {
+        return fd_;
+    }
+
+    /* Returns number of written bytes which are not sent yet. */
+    size_t pending() const noexcept {
+        return p_send->data.size() + queued.size();
+    }
+
+    /* Sets up to start receiving from `fd`. */
+    bool setup(int fd) {
+        if (fd < 0)
+            return false;
+        cancel();
+        fd_ = fd;
+        receiving = true;
+        if (!p_recv->in_flight)
+            submitReceive();
+        return true;
+    }
+
+    /* Stops receiving; written data is still sent. */
+    bool cancel() {
+        if (!receiving)
+            return false;
+        receiving = false;
+        if (p_recv->in_flight) {
+            auto p_sqe = p_loop->prepare(nullptr);
+            p_sqe->opcode = IORING_OP_ASYNC_CANCEL;
+            p_sqe->addr = reinterpret_cast<uint64_t>(p_recv);
+        }
+        return true;
+    }
+
+    /* Writes `data` to send; data written while a send is in flight is sent by the next one. */
+    bool write(const char* data, size_t size) {
+        if (fd_ < 0)
+            return false;
+        if (p_send->in_flight) {
+            queued.insert(queued.end(), data, data + size);
+        } else if (size > 0) {
+            p_send->data.assign(data, data + size);
+            submitSend();
+        }
+        return true;
+    }
+
+  private:
+    OnEvent on_event;
+    UringLoop* p_loop;
+    UringLoop::Slot* p_recv;
+    UringLoop::Slot* p_send;
+    std::vector<char> queued;
+    int fd_ = -1;
+    bool receiving = false;
+
+    void submitReceive() {
+        auto p_sqe = p_loop->prepare(p_recv);
+        p_sqe->opcode = IORING_OP_RECV;
+        p_sqe->fd = fd_;
+        p_sqe->flags = IOSQE_BUFFER_SELECT;
+        p_sqe->buf_group = UringLoop::BUFFER_GROUP;
+        if (p_loop->multishot_)
+            p_sqe->ioprio = IORING_RECV_MULTISHOT;
+    }
+
+    void submitSend() {
+        auto p_sqe = p_loop->prepare(p_send);
+        p_sqe->opcode = IORING_OP_SEND;
+        p_sqe->fd = fd_;
+        p_sqe->addr = reinterpret_cast<uint64_t>(p_send->data.data());
+        p_sqe->len = unsigned(p_send->data.size());
+        p_sqe->msg_flags = MSG_NOSIGNAL;
+    }
+
+    /* Handles completion of receive; handler is called the last, as it may destroy this. */
+    void received(const struct io_uring_cqe& cqe, bool more) {
+        auto result = cqe.res;
+        if ((result == -EINVAL) && p_loop->multishot_) {
+            p_loop->multishot_ = false; // kernel older than 6.0
+            result = -ENOBUFS;
+        }
+        if (result == -ECANCELED) {
+            if (!more && receiving)
+                submitReceive(); // set up again after cancel
+        } else if ((result > 0) || (result == -ENOBUFS)) {
+            if (!more && receiving)
+                submitReceive();
+            if (result > 0) {
+                UringLoop::Chunk chunk{p_loop->buffers.data() + (cqe.flags >> IORING_CQE_BUFFER_SHIFT) *
+                                                                    size_t(p_loop->buffer_size),
+                                       size_t(result)};
+                on_event(Event::READ, (void*)&chunk);
+            }
+        } else {
+            receiving = false;
+            if (result == 0) {
+                UringLoop::Chunk chunk{nullptr, 0};
+                on_event(Event::READ, (void*)&chunk);
+            } else
+                on_event(Event::READ | Event::ERROR, nullptr);
+        }
+    }
+
+    /* Handles completion of send; handler is called the last, as it may destroy this. */
+    void sent(const struct io_uring_cqe& cqe) {
+        auto& data = p_send->data;
+        if (cqe.res < 0) {
+            data.clear();
+            queued.clear();
+            on_event(Event::WRITE | Event::ERROR, nullptr);
+            return;
+        }
+        data.erase(data.begin(), data.begin() + cqe.res);
+        if (data.empty())
+            data.swap(queued);
+        else
+            data.insert(data.end(), queued.begin(), queued.end());
+        queued.clear();
+        if (!data.empty())
+            submitSend();
+        else
+            on_event(Event::WRITE, nullptr);
+    }
+};
+
+
+inline bool UringLoop::runOnce(bool wait) {
+    auto cq_head = *cq_head_ptr;
+    if (cq_head == __atomic_load_n(cq_tail_ptr, __ATOMIC_ACQUIRE)) {
+        if ((in_flight == 0) && (sq_tail == sq_submitted))
+            return false;
+        enter(wait ? 1 : 0);
+    } else if (sq_tail != sq_submitted)
+        enter(0);
+    auto cq_tail = __atomic_load_n(cq_tail_ptr, __ATOMIC_ACQUIRE);
+    while (cq_head != cq_tail) {
+        auto cqe = cqes[cq_head & cq_mask];
+        __atomic_store_n(cq_head_ptr, ++cq_head, __ATOMIC_RELEASE);
+        auto p_slot = reinterpret_cast<Slot*>(cqe.user_data);
+        if (p_slot == nullptr)
+            continue; // completion of cancel request
+        bool more = (cqe.flags & IORING_CQE_F_MORE) != 0;
+        if (!more) {
+            p_slot->in_flight = false;
+            in_flight--;
+        }
+        auto p_stream = p_slot->p_stream;
+        if (p_stream == nullptr) {
+            if (!more)
+                freeSlot(p_slot);
+        } else if (p_slot->receive)
+            p_stream->received(cqe, more);
+        else
+            p_stream->sent(cqe);
+        if (cqe.flags & IORING_CQE_F_BUFFER)
+            recycle(uint16_t(cqe.flags >> IORING_CQE_BUFFER_SHIFT));
+    }
+    return true;
+}
+} // squall::core
+} // squall
+#endif // HAVE_IO_URING_H
+#endif // SQUALL__CORE__URING_LOOP_HXX
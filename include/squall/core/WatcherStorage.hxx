@@ -0,0 +1,322 @@
+#ifndef SQUALL__CORE__WATCHER_STORAGE_HXX
+#define SQUALL__CORE__WATCHER_STORAGE_HXX
+#include <memory>
+#include <vector>
+#include <cstdint>
+#include <utility>
+#include <functional>
+#include <type_traits>
+#include <unordered_map>
+#include "NonCopyable.hxx"
+
+namespace squall {
+namespace core {
+
+
+/*
+ * Watcher storage policies of dispatcher.
+ * Each keeps values of type `W` by context of type `Ctx`,
+ * and values have stable addresses while they are stored.
+ * `emplace` returns nullptr if storage cannot keep given context.
+ */
+
+
+/* Storage with a hash map node and a separate heap value per context. */
+template <typename Ctx, typename W>
+class HashStorage : NonCopyable {
+  public:
+    /* Returns number of stored values. */
+    size_t size() const noexcept {
+        return values.size();
+    }
+
+    /* Returns pointer to value stored for `ctx` or nullptr. */
+    W* find(const Ctx& ctx) const noexcept {
+        auto found = values.find(ctx);
+        return (found != values.end()) ? found->second.get() : nullptr;
+    }
+
+    /* Constructs value for `ctx` from `args`; `ctx` must not be stored yet. */
+    template <typename... Args>
+    W* emplace(const Ctx& ctx, Args&&... args) {
+        auto up_value = std::unique_ptr<W>(new W(std::forward<Args>(args)...));
+        auto p_value = up_value.get();
+        values.insert(std::make_pair(ctx, std::move(up_value)));
+        return p_value;
+    }
+
+    /* Destroys value stored for `ctx`. */
+    bool erase(const Ctx& ctx) {
+        return values.erase(ctx) > 0;
+    }
+
+    /* Calls `func` with each stored context; `func` must not modify storage. */
+    template <typename Func>
+    void forEach(Func&& func) const {
+        for (auto const& pair : values)
+            func(pair.first);
+    }
+
+  private:
+    std::unordered_map<Ctx, std::unique_ptr<W>> values;
+};
+
+
+/*
+ * Storage with values in a chunked arena and an open addressing index.
+ * Chunks are never moved, freed slots are reused, so setup/cancel churn
+ * does not hit the allocator; it is called only when storage grows.
+ */
+template <typename Ctx, typename W>
+class ArenaStorage : NonCopyable {
+  public:
+    /* Destructor */
+    ~ArenaStorage() {
+        for (auto id : index)
+            if (id != NIL)
+                entry(id)->~Entry();
+    }
+
+    /* Returns number of stored values. */
+    size_t size() const noexcept {
+        return count;
+    }
+
+    /* Returns pointer to value stored for `ctx` or nullptr. */
+    W* find(const Ctx& ctx) const noexcept {
+        auto pos = lookup(ctx);
+        return (pos != NIL) ? &entry(index[pos])->value : nullptr;
+    }
+
+    /* Constructs value for `ctx` from `args`; `ctx` must not be stored yet. */
+    template <typename... Args>
+    W* emplace(const Ctx& ctx, Args&&... args) {
+        if ((count + 1) * 2 > index.size())
+            rehash((index.size() > 0) ? index.size() * 2 : 16);
+        if (free_head == NIL)
+            grow();
+        auto id = free_head;
+        auto p_slot = slot(id);
+        new (&p_slot->storage) Entry(ctx, std::forward<Args>(args)...);
+        free_head = p_slot->next;
+        auto pos = home(ctx);
+        while (index[pos] != NIL)
+            pos = (pos + 1) & mask();
+        index[pos] = id;
+        count++;
+        return &entry(id)->value;
+    }
+
+    /* Destroys value stored for `ctx`. */
+    bool erase(const Ctx& ctx) {
+        auto pos = lookup(ctx);
+        if (pos == NIL)
+            return false;
+        auto id = index[pos];
+        // backward shift deletion; keeps probe chains without tombstones
+        for (auto next = (pos + 1) & mask(); index[next] != NIL; next = (next + 1) & mask()) {
+            auto desired = home(entry(index[next])->ctx);
+            if (((next > pos) && ((desired <= pos) || (desired > next))) ||
+                ((next < pos) && (desired <= pos) && (desired > next))) {
+                index[pos] = index[next];
+                pos = next;
+            }
+        }
+        index[pos] = NIL;
+        count--;
+        entry(id)->~Entry();
+        slot(id)->next = free_head;
+        free_head = id;
+        return true;
+    }
+
+    /* Calls `func` with each stored context; `func` must not modify storage. */
+    template <typename Func>
+    void forEach(Func&& func) const {
+        for (auto id : index)
+            if (id != NIL)
+                func(entry(id)->ctx);
+    }
+
+  private:
+    static const uint32_t NIL = UINT32_MAX;
+    static const uint32_t CHUNK_BITS = 8;
+    static const uint32_t CHUNK_SIZE = 1 << CHUNK_BITS;
+
+    struct Entry {
+        Ctx ctx;
+        W value;
+
+        template <typename... Args>
+        Entry(const Ctx& ctx, Args&&... args) : ctx(ctx), value(std::forward<Args>(args)...) {}
+    };
+
+    struct Slot {
+        typename std::aligned_storage<sizeof(Entry), alignof(Entry)>::type storage;
+        uint32_t next;
+    };
+
+    std::vector<std::unique_ptr<Slot[]>> chunks;
+    std::vector<uint32_t> index;
+    uint32_t free_head = NIL;
+    size_t count = 0;
+
+    Slot* slot(uint32_t id) const noexcept {
+        return &chunks[id >> CHUNK_BITS][id & (CHUNK_SIZE - 1)];
+    }
+
+    Entry* entry(uint32_t id) const noexcept {
+        return reinterpret_cast<Entry*>(&slot(id)->storage);
+    }
+
+    size_t mask() const noexcept {
+        return index.size() - 1;
+    }
+
+    /* Returns the first index position probed for `ctx`. */
+    size_t home(const Ctx& ctx) const noexcept {
+        uint64_t hash = std::hash<Ctx>()(ctx);
+        // std::hash of integers and pointers is identity; spread bits for linear probing
+        hash ^= hash >> 33;
+        hash *= 0xff51afd7ed558ccdULL;
+        hash ^= hash >> 33;
+        return size_t(hash) & mask();
+    }
+
+    /* Returns index position of `ctx` or NIL. */
+    size_t lookup(const Ctx& ctx) const noexcept {
+        if (count == 0)
+            return NIL;
+        for (auto pos = home(ctx); index[pos] != NIL; pos = (pos + 1) & mask())
+            if (entry(index[pos])->ctx == ctx)
+                return pos;
+        return NIL;
+    }
+
+    /* Rebuilds index with given `size`, which is a power of two. */
+    void rehash(size_t size) {
+        std::vector<uint32_t> old_index(size, NIL);
+        old_index.swap(index);
+        for (auto id : old_index)
+            if (id != NIL) {
+                auto pos = home(entry(id)->ctx);
+                while (index[pos] != NIL)
+                    pos = (pos + 1) & mask();
+                index[pos] = id;
+            }
+    }
+
+    /* Adds a chunk of free slots. */
+    void grow() {
+        uint32_t first = chunks.size() * CHUNK_SIZE;
+        chunks.emplace_back(new Slot[CHUNK_SIZE]);
+        auto p_chunk = chunks.back().get();
+        for (uint32_t i = 0; i < CHUNK_SIZE; i++)
+            p_chunk[i].next = (i + 1 < CHUNK_SIZE) ? first + i + 1 : free_head;
+        free_head = first;
+    }
+};
+
+template <typename Ctx, typename W>
+const uint32_t ArenaStorage<Ctx, W>::NIL;
+template <typename Ctx, typename W>
+const uint32_t ArenaStorage<Ctx, W>::CHUNK_BITS;
+template <typename Ctx, typename W>
+const uint32_t ArenaStorage<Ctx, W>::CHUNK_SIZE;
+
+/*
+ * Storage for integral contexts which are file descriptors.
+ * Values are directly addressed by `ctx` in chunks which are allocated
+ * on first use and never moved, so lookup is two indexations and no hash.
+ */
+template <typename Ctx, typename W>
+class FdStorage : NonCopyable {
+    static_assert(std::is_integral<Ctx>::value, "FdStorage needs integral context");
+
+  public:
+    /* Destructor */
+    ~FdStorage() {
+        forEach([this](const Ctx& ctx) { slot(ctx)->value()->~W(); });
+    }
+
+    /* Returns number of stored values. */
+    size_t size() const noexcept {
+        return count;
+    }
+
+    /* Returns pointer to value stored for `ctx` or nullptr. */
+    W* find(const Ctx& ctx) const noexcept {
+        auto p_slot = slot(ctx);
+        return ((p_slot != nullptr) && p_slot->used) ? p_slot->value() : nullptr;
+    }
+
+    /* Constructs value for `ctx` from `args`; returns nullptr if `ctx` is negative. */
+    template <typename... Args>
+    W* emplace(const Ctx& ctx, Args&&... args) {
+        if (ctx < 0)
+            return nullptr;
+        size_t number = size_t(ctx) >> CHUNK_BITS;
+        if (number >= chunks.size())
+            chunks.resize(number + 1);
+        if (!chunks[number])
+            chunks[number].reset(new Slot[CHUNK_SIZE]());
+        auto p_slot = slot(ctx);
+        new (&p_slot->storage) W(std::forward<Args>(args)...);
+        p_slot->used = true;
+        count++;
+        return p_slot->value();
+    }
+
+    /* Destroys value stored for `ctx`. */
+    bool erase(const Ctx& ctx) {
+        auto p_slot = slot(ctx);
+        if ((p_slot == nullptr) || !p_slot->used)
+            return false;
+        p_slot->used = false;
+        count--;
+        p_slot->value()->~W();
+        return true;
+    }
+
+    /* Calls `func` with each stored context; `func` must not modify storage. */
+    template <typename Func>
+    void forEach(Func&& func) const {
+        for (size_t number = 0; number < chunks.size(); number++)
+            if (chunks[number])
+                for (size_t i = 0; i < CHUNK_SIZE; i++)
+                    if (chunks[number][i].used)
+                        func(Ctx((number << CHUNK_BITS) + i));
+    }
+
+  private:
+    static const size_t CHUNK_BITS = 10;
+    static const size_t CHUNK_SIZE = size_t(1) << CHUNK_BITS;
+
+    struct Slot {
+        typename std::aligned_storage<sizeof(W), alignof(W)>::type storage;
+        bool used;
+
+        W* value() noexcept {
+            return reinterpret_cast<W*>(&storage);
+        }
+    };
+
+    std::vector<std::unique_ptr<Slot[]>> chunks;
+    size_t count = 0;
+
+    /* Returns slot of `ctx` or nullptr if its chunk is not allocated. */
+    Slot* slot(const Ctx& ctx) const noexcept {
+        size_t number = size_t(ctx) >> CHUNK_BITS;
+        if ((ctx < 0) || (number >= chunks.size()) || !chunks[number])
+            return nullptr;
+        return &chunks[number][size_t(ctx) & (CHUNK_SIZE - 1)];
+    }
+};
+
+template <typename Ctx, typename W>
+const size_t FdStorage<Ctx, W>::CHUNK_BITS;
+template <typename Ctx, typename W>
+const size_t FdStorage<Ctx, W>::CHUNK_SIZE;
+} // squall::core
+} // squall
+#endif // SQUALL__CORE__WATCHER_STORAGE_HXX
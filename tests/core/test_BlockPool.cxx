@@ -0,0 +1,87 @@
+#include <string>
+#include <squall/core/BlockPool.hxx>
+#include <squall/core/BufferStorage.hxx>
+#include "../catch.hpp"
+
+using squall::core::BlockPool;
+using squall::core::BufferStorage;
+
+
+TEST_CASE("Unittest squall::core::BlockPool", "[buffers]") {
+
+    auto sp_pool = BlockPool::createShared(64, 2, 3);
+    REQUIRE(sp_pool->blockSize() == 64);
+
+    auto a = sp_pool->borrow();
+    auto b = sp_pool->borrow();
+    auto c = sp_pool->borrow();
+    REQUIRE((a && b && c));
+    REQUIRE(sp_pool->borrow() == nullptr); // limit of borrowed blocks
+    REQUIRE(sp_pool->stats().borrowed == 3);
+    REQUIRE(sp_pool->stats().allocations == 3);
+    REQUIRE(sp_pool->stats().misses == 1);
+
+    sp_pool->giveBack(a);
+    sp_pool->giveBack(b);
+    sp_pool->giveBack(c); // over limit of cached blocks; freed
+    REQUIRE(sp_pool->stats().borrowed == 0);
+    REQUIRE(sp_pool->stats().cached == 2);
+
+    REQUIRE(sp_pool->borrow() == b); // reuses cached block
+    REQUIRE(sp_pool->stats().allocations == 3);
+    sp_pool->giveBack(b);
+    sp_pool->setMaxCached(1);
+    REQUIRE(sp_pool->stats().cached == 1);
+    sp_pool->shrink();
+    REQUIRE(sp_pool->stats().cached == 0);
+}
+
+
+TEST_CASE("Unittest squall::core::BufferStorage with BlockPool", "[buffers]") {
+
+    auto sp_pool = BlockPool::createShared(64, 8);
+    BufferStorage storage;
+    storage.append("0123", 4);
+    storage.setBlockPool(sp_pool);
+    REQUIRE(storage.capacity() == 4); // not empty; keeps its memory
+    storage.consume(4);
+    REQUIRE(storage.capacity() == 0); // drained; memory released
+
+    storage.append("0123456789", 10);
+    REQUIRE(storage.capacity() == 64);
+    REQUIRE(sp_pool->stats().borrowed == 1);
+    storage.consume(5);
+    storage.append(std::string(100, 'X').data(), 100); // does not fit into block
+    REQUIRE(storage.capacity() >= 105);
+    REQUIRE(std::string(storage.data(), 5) == "56789");
+    REQUIRE(sp_pool->stats().borrowed == 0);
+    REQUIRE(sp_pool->stats().cached == 1);
+    storage.clear();
+    REQUIRE(storage.capacity() == 0);
+
+    storage.prepare(16);
+    REQUIRE(sp_pool->stats().borrowed == 1);
+    auto allocations = sp_pool->stats().allocations;
+    storage.commit(0); // nothing received; idle storage holds no block
+    REQUIRE(storage.capacity() == 0);
+    REQUIRE(sp_pool->stats().borrowed == 0);
+    REQUIRE(sp_pool->stats().cached == 1);
+    storage.prepare(16);
+    REQUIRE(sp_pool->stats().borrowed == 1);
+    REQUIRE(sp_pool->stats().allocations == allocations); // cached block is reused
+    storage.commit(1);
+    storage.consume(1); // drained
+    REQUIRE(storage.capacity() == 0);
+    REQUIRE(sp_pool->stats().borrowed == 0);
+
+    sp_pool->setMaxBorrowed(1);
+    BufferStorage other;
+    other.setBlockPool(sp_pool);
+    storage.append("A", 1);
+    other.append("B", 1); // pool limit reached; heap memory
+    REQUIRE(sp_pool->stats().borrowed == 1);
+    REQUIRE(sp_pool->stats().misses == 1);
+    REQUIRE(other.capacity() == 1);
+    storage.release();
+    REQUIRE(sp_pool->stats().borrowed == 0);
+}
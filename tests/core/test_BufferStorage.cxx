@@ -0,0 +1,56 @@
+#include <string>
+#include <squall/core/BufferStorage.hxx>
+#include "../catch.hpp"
+
+using squall::core::BufferStorage;
+
+
+inline std::string cnv(const BufferStorage& storage) {
+    return std::string(storage.data(), storage.size());
+}
+
+
+TEST_CASE("Unittest squall::core::BufferStorage", "[buffers]") {
+
+    BufferStorage storage;
+    REQUIRE(storage.empty());
+    REQUIRE(storage.capacity() == 0);
+
+    storage.append("0123456789ABCDEF", 16);
+    REQUIRE(storage.size() == 16);
+    REQUIRE(storage.capacity() == 16);
+    REQUIRE(cnv(storage) == "0123456789ABCDEF");
+
+    // consume from the front does not move data
+    auto p_data = storage.data();
+    storage.consume(4);
+    REQUIRE(storage.data() == p_data + 4);
+    REQUIRE(cnv(storage) == "456789ABCDEF");
+
+    // not enough consumed; storage grows instead of moving
+    storage.append("GH", 2);
+    REQUIRE(storage.capacity() == 32);
+    REQUIRE(cnv(storage) == "456789ABCDEFGH");
+
+    // enough consumed; storage compacts in place
+    storage.consume(10);
+    REQUIRE(cnv(storage) == "EFGH");
+    auto p_prepared = storage.prepare(26);
+    REQUIRE(storage.capacity() == 32);
+    REQUIRE(storage.data() == p_prepared - 4);
+    std::memcpy(p_prepared, "IJ", 2);
+    storage.commit(2);
+    REQUIRE(cnv(storage) == "EFGHIJ");
+
+    // full consume resets offsets
+    storage.consume(6);
+    REQUIRE(storage.empty());
+    REQUIRE(storage.prepare(32) == storage.data());
+    storage.commit(0);
+    REQUIRE(storage.empty());
+
+    storage.append("XYZ", 3);
+    storage.clear();
+    REQUIRE(storage.empty());
+    REQUIRE(storage.capacity() == 32);
+}
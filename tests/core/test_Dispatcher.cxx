@@ -1,5 +1,8 @@
+#include <chrono>
+#include <algorithm>
 #include <string>
 #include <memory>
+#include <unistd.h>
 #include <squall/core/Dispatcher.hxx>
 #include <squall/core/PlatformLoop.hxx>
 #include "../catch.hpp"
@@ -7,6 +10,8 @@
 using squall::core::Event;
 using squall::core::PlatformLoop;
 using squall::core::Dispatcher;
+using squall::core::ArenaStorage;
+using squall::core::FdDispatcher;
 
 
 TEST_CASE("Contexted event dispatcher; unit test", "[dispatcher]") {
@@ -50,3 +55,251 @@ TEST_CASE("Contexted event dispatcher; unit test", "[dispatcher]") {
     REQUIRE(sp_loop.use_count() == 1);
     REQUIRE(result == "AWABAAABAAAAACC");
 };
+
+
+TEST_CASE("Contexted event dispatcher; feed I/O event", "[dispatcher]") {
+
+    std::string result;
+    int fds[2];
+    REQUIRE(pipe(fds) == 0);
+    auto sp_loop = PlatformLoop::createShared();
+
+    Dispatcher<char const*> disp(
+        [&](const char* ch, int revents, void* payload) {
+            if (revents == Event::READ) {
+                result += ch;
+                if (result.size() < 3)
+                    disp.feedIoWatching(ch, Event::READ);
+                else
+                    sp_loop->stop();
+            }
+        },
+        sp_loop);
+
+    REQUIRE(!disp.feedIoWatching("F", Event::READ));
+    disp.setupIoWatching("F", fds[0], Event::READ); // nothing to read
+    REQUIRE(disp.feedIoWatching("F", Event::READ));
+    sp_loop->start();
+    REQUIRE(result == "FFF");
+
+    // event fed to paused watching is dropped by cancel
+    REQUIRE(!disp.updateIoWatching("F", 0));
+    REQUIRE(disp.feedIoWatching("F", Event::READ));
+    REQUIRE(disp.cancelIoWatching("F"));
+    sp_loop->runIterations(1);
+    REQUIRE(result == "FFF");
+
+    squall::core::IoWatcher watcher([&](int revents, void* payload) { result += "W"; }, sp_loop);
+    watcher.feed(Event::READ);
+    REQUIRE(!watcher.cancel());
+    sp_loop->runIterations(1);
+    REQUIRE(result == "FFF");
+
+    disp.release();
+    close(fds[0]);
+    close(fds[1]);
+};
+
+
+/* Dispatcher handler given as a functor type. */
+struct CountingHandler {
+    std::string& result;
+    std::shared_ptr<PlatformLoop> sp_loop;
+
+    void operator()(int ctx, int revents, void* payload) {
+        result += (revents == Event::CLEANUP) ? "C" : std::to_string(ctx);
+        if ((result.size() == 3) || (revents == Event::TIMEOUT))
+            sp_loop->stop();
+    }
+};
+
+
+TEST_CASE("Contexted event dispatcher; functor handler", "[dispatcher]") {
+
+    std::string result;
+    int fds[2];
+    REQUIRE(pipe(fds) == 0);
+    auto sp_loop = PlatformLoop::createShared();
+
+    Dispatcher<int, CountingHandler> disp(CountingHandler{result, sp_loop}, sp_loop);
+    disp.setupIoWatching(7, fds[1], Event::WRITE);
+    sp_loop->start();
+    REQUIRE(result == "777");
+    REQUIRE(disp.updateIoWatching(7, Event::READ)); // nothing to read
+    disp.setupTimerWatching(5, 0.01);
+    sp_loop->start();
+    REQUIRE(result == "7775");
+
+    disp.release();
+    REQUIRE(result == "7775CC");
+    close(fds[0]);
+    close(fds[1]);
+};
+
+
+TEST_CASE("Contexted event dispatcher; arena storage", "[dispatcher]") {
+
+    std::string result;
+    auto sp_loop = PlatformLoop::createShared();
+
+    Dispatcher<int, CountingHandler, ArenaStorage> disp(CountingHandler{result, sp_loop}, sp_loop);
+    for (int i = 0; i < 1000; i++)
+        disp.setupTimerWatching(i, 10);
+    for (int i = 0; i < 1000; i++)
+        if (i != 3)
+            REQUIRE(disp.cancelTimerWatching(i));
+    REQUIRE(!disp.cancelTimerWatching(1000));
+    disp.setupTimerWatching(3, 0.01); // re-setup of existing watcher
+    sp_loop->start();
+    REQUIRE(result == "3");
+
+    disp.release();
+    REQUIRE(result == "3C");
+};
+
+
+/* Dispatcher handler which keeps the last event and stops loop. */
+struct LastEventHandler {
+    std::pair<int, int>& last;
+    std::shared_ptr<PlatformLoop> sp_loop;
+
+    void operator()(int fd, int revents, void* payload) {
+        last = std::make_pair(fd, revents);
+        if (revents != Event::CLEANUP)
+            sp_loop->stop();
+    }
+};
+
+
+TEST_CASE("Contexted event dispatcher; indexed by fd", "[dispatcher]") {
+
+    std::pair<int, int> last(0, 0);
+    int fds[2];
+    REQUIRE(pipe(fds) == 0);
+    auto sp_loop = PlatformLoop::createShared();
+
+    FdDispatcher<LastEventHandler> disp(LastEventHandler{last, sp_loop}, sp_loop);
+    REQUIRE_THROWS(disp.setupIoWatching(-1, -1, Event::READ));
+    REQUIRE(!disp.updateIoWatching(fds[1], Event::WRITE));
+    disp.setupIoWatching(fds[1], fds[1], Event::READ); // nothing to read
+    REQUIRE(disp.updateIoWatching(fds[1], Event::WRITE));
+    sp_loop->start();
+    REQUIRE(last == std::make_pair(fds[1], int(Event::WRITE)));
+    REQUIRE(disp.cancelIoWatching(fds[1]));
+    REQUIRE(!disp.cancelIoWatching(fds[1]));
+
+    disp.setupIoWatching(fds[0], fds[0], Event::READ);
+    disp.release();
+    REQUIRE(last == std::make_pair(fds[0], int(Event::CLEANUP)));
+    close(fds[0]);
+    close(fds[1]);
+};
+
+
+TEST_CASE("Contexted event dispatcher; timeouts", "[dispatcher]") {
+
+    std::string result;
+    auto sp_loop = PlatformLoop::createShared();
+
+    Dispatcher<char const*> disp(
+        [&](const char* ch, int revents, void* payload) {
+            result += (revents == Event::TIMEOUT) ? ch : "C";
+            if (ch[0] == 'A')
+                disp.setupTimeoutWatching("B", 0.02); // re-armed before expiration
+            else if (ch[0] == 'B')
+                sp_loop->stop();
+        },
+        sp_loop, 0.005);
+    REQUIRE(disp.timeoutResolution() == 0.005);
+
+    disp.setupTimeoutWatching("A", 0.02);
+    disp.setupTimeoutWatching("B", 0.03);
+    disp.setupTimeoutWatching("C", 0.01);
+    REQUIRE(disp.cancelTimeoutWatching("C"));
+    REQUIRE(!disp.cancelTimeoutWatching("C"));
+    sp_loop->start();
+    REQUIRE(result == "AB");
+    REQUIRE(!disp.cancelTimeoutWatching("A")); // expired timeout is released
+
+    disp.setupTimeoutWatching("D", 10);
+    disp.release();
+    REQUIRE(result == "ABC");
+};
+
+
+TEST_CASE("Contexted event dispatcher; timeouts without loop", "[dispatcher]") {
+    Dispatcher<char const*> disp([](const char* ch, int revents, void* payload) {}, nullptr, -1);
+    REQUIRE(!disp.active());
+    REQUIRE(disp.timeoutResolution() == 0.001);
+    REQUIRE_THROWS(disp.setupTimeoutWatching("A", 1));
+    REQUIRE(!disp.cancelTimeoutWatching("A"));
+};
+
+
+TEST_CASE("Contexted event dispatcher; activity timeouts", "[dispatcher]") {
+
+    std::string result;
+    auto sp_loop = PlatformLoop::createShared();
+
+    Dispatcher<char const*> disp(
+        [&](const char* ch, int revents, void* payload) {
+            result += (revents == Event::TIMEOUT) ? ch : "C";
+            if (ch[0] == 'T') {
+                REQUIRE(disp.touchActivityWatching("I"));
+                if (result.size() == 5)
+                    disp.cancelTimerWatching("T"); // no more activity
+            } else if (ch[0] == 'I')
+                sp_loop->stop();
+        },
+        sp_loop);
+
+    REQUIRE(!disp.touchActivityWatching("I"));
+    auto started = std::chrono::steady_clock::now();
+    disp.setupActivityWatching("I", 0.05);
+    disp.setupTimerWatching("T", 0.01);
+    sp_loop->start();
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - started;
+    REQUIRE(result == "TTTTTI");
+    REQUIRE(elapsed.count() >= 0.09); // counted from the last touch
+
+    REQUIRE(disp.touchActivityWatching("I")); // expired one stays until canceled
+    disp.release();
+    REQUIRE(result == "TTTTTIC");
+};
+
+
+TEST_CASE("Contexted event dispatcher; prepare, check and idle", "[dispatcher]") {
+
+    std::string result;
+    auto sp_loop = PlatformLoop::createShared();
+
+    Dispatcher<char const*> disp(
+        [&](const char* ch, int revents, void* payload) {
+            if (revents == Event::CLEANUP) {
+                result += "C";
+                return;
+            }
+            REQUIRE(revents == ((ch[0] == 'P') ? Event::PREPARE : (ch[0] == 'K') ? Event::CHECK : Event::IDLE));
+            result += ch;
+            if ((ch[0] == 'I') && (std::count(result.begin(), result.end(), 'I') == 3)) {
+                REQUIRE(disp.cancelIdleWatching("I"));
+                sp_loop->stop();
+            }
+        },
+        sp_loop);
+
+    disp.setupPrepareWatching("P");
+    disp.setupCheckWatching("K");
+    disp.setupIdleWatching("I");
+    disp.setupIdleWatching("I"); // already running
+    sp_loop->start();
+    REQUIRE(result[0] == 'P'); // prepare is called before the first polling
+    REQUIRE(std::count(result.begin(), result.end(), 'P') == 3);
+    REQUIRE(std::count(result.begin(), result.end(), 'K') == 3);
+    REQUIRE(!disp.cancelIdleWatching("I"));
+
+    REQUIRE(disp.cancelCheckWatching("K"));
+    result.clear();
+    disp.release();
+    REQUIRE(result == "C");
+};
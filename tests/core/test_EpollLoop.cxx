@@ -0,0 +1,142 @@
+#ifdef HAVE_EPOLL_H
+#include <string>
+#include <memory>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <squall/core/EpollLoop.hxx>
+#include "../catch.hpp"
+
+using squall::core::Event;
+using squall::core::EpollLoop;
+using squall::core::EpollWatcher;
+
+
+TEST_CASE("Unittest squall::core::EpollLoop", "[loops]") {
+    int fds[2];
+    REQUIRE(socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+
+    auto sp_loop = EpollLoop::createShared(4);
+    REQUIRE(sp_loop->batch() == 4);
+    REQUIRE(!sp_loop->runOnce()); // nothing is watched
+
+    std::string result;
+    EpollWatcher watcher([&](int revents, void* payload) {
+        REQUIRE(payload == &watcher);
+        if (revents & Event::WRITE) {
+            result += "W";
+            REQUIRE(write(fds[0], "ABC", 3) == 3);
+            watcher.setup(fds[0], Event::READ);
+        } else if (revents & Event::READ) {
+            char buff[8];
+            auto size = read(fds[0], buff, sizeof(buff));
+            result += std::string(buff, size > 0 ? size : 0);
+            if (size <= 0)
+                watcher.cancel();
+        }
+    }, sp_loop);
+
+    REQUIRE(!watcher.setup(fds[0], 0));
+    REQUIRE(watcher.setup(fds[0], Event::WRITE));
+    REQUIRE(watcher.running());
+    REQUIRE(watcher.fd() == fds[0]);
+    REQUIRE(watcher.mode() == Event::WRITE);
+    REQUIRE(!watcher.edge());
+
+    EpollWatcher echo([&](int revents, void* payload) {
+        char buff[8];
+        auto size = read(fds[1], buff, sizeof(buff));
+        REQUIRE(size == 3);
+        REQUIRE(write(fds[1], buff, size) == size);
+        shutdown(fds[1], SHUT_WR);
+        static_cast<EpollWatcher*>(payload)->cancel();
+    }, sp_loop);
+    REQUIRE(echo.setup(fds[1], Event::READ));
+
+    sp_loop->start(); // returns when nothing is watched
+    REQUIRE(result == "WABC");
+    REQUIRE(!watcher.running());
+    REQUIRE(!echo.running());
+    REQUIRE(!sp_loop->running());
+    close(fds[0]);
+    close(fds[1]);
+}
+
+
+TEST_CASE("Edge-triggered squall::core::EpollWatcher", "[loops]") {
+    int fds[2];
+    REQUIRE(socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+    auto sp_loop = EpollLoop::createShared();
+
+    int level = 0, edge = 0;
+    EpollWatcher level_watcher([&](int revents, void* payload) { level++; }, sp_loop);
+    EpollWatcher edge_watcher([&](int revents, void* payload) { edge++; }, sp_loop);
+    int dup_fd = dup(fds[1]); // epoll watches file description once per fd
+    REQUIRE(level_watcher.setup(fds[1], Event::READ));
+    REQUIRE(edge_watcher.setup(dup_fd, Event::READ, true));
+    REQUIRE(edge_watcher.edge());
+
+    REQUIRE(write(fds[0], "A", 1) == 1);
+    for (int i = 0; i < 3; i++)
+        REQUIRE(sp_loop->runOnce(10));
+    REQUIRE(level == 3);
+    REQUIRE(edge == 1); // not read data does not trigger it again
+
+    REQUIRE(write(fds[0], "B", 1) == 1);
+    REQUIRE(sp_loop->runOnce(10));
+    REQUIRE(level == 4);
+    REQUIRE(edge == 2);
+    close(dup_fd);
+    close(fds[0]);
+    close(fds[1]);
+}
+
+
+TEST_CASE("Canceled squall::core::EpollWatcher drops fetched events", "[loops]") {
+    int fds[2];
+    REQUIRE(socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+    auto sp_loop = EpollLoop::createShared();
+
+    int calls = 0;
+    std::unique_ptr<EpollWatcher> up_first, up_second;
+    auto on_event = [&](int revents, void* payload) {
+        calls++;
+        // the other one is ready too, but it is destroyed before its event is handled
+        if (payload == up_first.get())
+            up_second.reset();
+        else
+            up_first.reset();
+    };
+    up_first.reset(new EpollWatcher(on_event, sp_loop));
+    up_second.reset(new EpollWatcher(on_event, sp_loop));
+    REQUIRE(up_first->setup(fds[0], Event::WRITE));
+    REQUIRE(up_second->setup(fds[1], Event::WRITE));
+    REQUIRE(sp_loop->runOnce(10));
+    REQUIRE(calls == 1);
+    close(fds[0]);
+    close(fds[1]);
+}
+
+
+TEST_CASE("squall::core::EpollWatcher set up again on reused fd", "[loops]") {
+    int fds[2];
+    REQUIRE(socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+    auto sp_loop = EpollLoop::createShared();
+
+    int calls = 0;
+    EpollWatcher watcher([&](int revents, void* payload) { calls++; }, sp_loop);
+    REQUIRE(watcher.setup(fds[0], Event::READ));
+    close(fds[0]); // the kernel forgets it
+    REQUIRE(dup(fds[1]) == fds[0]);
+    REQUIRE(watcher.setup(fds[0], Event::WRITE));
+    REQUIRE(watcher.running());
+    REQUIRE(sp_loop->runOnce(10));
+    REQUIRE(calls == 1);
+
+    close(fds[0]);
+    REQUIRE(!watcher.setup(fds[0], Event::WRITE)); // fd is not open
+    REQUIRE(!watcher.running());
+    REQUIRE(!sp_loop->runOnce(10)); // nothing is watched
+    REQUIRE(calls == 1);
+    close(fds[1]);
+}
+#endif // HAVE_EPOLL_H
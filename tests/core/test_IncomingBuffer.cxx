@@ -254,4 +254,112 @@ TEST_CASE("Unittest squall::IncommingBuffer", "[buffer]") {
 
                           // clang-format on
                       }));
-}
\ No newline at end of file
+}
+
+TEST_CASE("Unittest squall::IncommingBuffer delimiter split between blocks", "[buffer]") {
+
+    std::vector<intptr_t> callog;
+    std::vector<std::string> frames;
+
+    IncomingBufferTest in(callog, [](bool) { return true; }, 8, 64);
+
+    auto handler = [&frames](int revents, void* payload) {
+        auto p_buff = static_cast<IncomingBufferTest*>(payload);
+        if (revents == (Event::BUFFER | Event::READ))
+            frames.push_back(cnv(p_buff->read(p_buff->lastResult())));
+    };
+
+    REQUIRE(in.setup(handler, cnv("\r\n\r\n"), 64) == 0);
+    in.applyData(cnv("HEAD 01\r\n\r"));
+    in.applyData(cnv("\nHEAD 02\r\nX: Y\r\n\r\nTAIL"));
+    while (in.size() < 4)
+        in(Event::READ);
+    REQUIRE(frames.empty());
+    for (int i = 0; i < 4; i++)
+        in(Event::READ);
+    REQUIRE(frames == std::vector<std::string>({"HEAD 01\r\n\r\n", "HEAD 02\r\nX: Y\r\n\r\n"}));
+    REQUIRE(cnv(in.read(64)) == "TAIL");
+    REQUIRE(in.lastResult() == 0);
+}
+
+
+TEST_CASE("Unittest squall::IncommingBuffer peek and consume", "[buffer]") {
+
+    std::vector<intptr_t> callog;
+    std::vector<std::string> frames;
+
+    IncomingBufferTest in(callog, [](bool) { return true; }, 8, 32);
+
+    auto handler = [&frames](int revents, void* payload) {
+        auto p_buff = static_cast<IncomingBufferTest*>(payload);
+        if (revents == (Event::BUFFER | Event::READ)) {
+            auto view = p_buff->peek();
+            frames.push_back(std::string(view.first, view.second));
+            p_buff->consume(view.second);
+        }
+    };
+
+    REQUIRE(in.peek().second == 0); // no buffer task
+    in.applyData(cnv("AB\nCDE\nF"));
+    in(Event::READ);
+    REQUIRE(in.peek().second == 0);
+    REQUIRE(in.peek(3).second == 3);
+    REQUIRE(std::string(in.peek(3).first, 3) == "AB\n");
+    REQUIRE(in.peek(100).second == 8);
+    REQUIRE(in.setup(handler, cnv("\n"), 32) == 3);
+    REQUIRE(std::string(in.peek().first, in.peek().second) == "AB\n");
+    in.consume(3);
+    REQUIRE(in.size() == 5);
+    in.applyData(cnv("GH\n"));
+    in(Event::READ);
+    REQUIRE(frames == std::vector<std::string>({"CDE\n"}));
+    in.consume(100);
+    REQUIRE(in.size() == 0);
+}
+
+
+TEST_CASE("Unittest squall::IncommingBuffer drain budget", "[buffer]") {
+
+    std::vector<intptr_t> callog;
+    int renotified = 0;
+    IncomingBufferTest in(callog, [](bool) { return true; }, 8, 64);
+
+    in.setDrainBudget(20, 0, [&renotified]() { renotified++; });
+    REQUIRE(in.drainBudget() == 20);
+    in.applyData(cnv("0123456789ABCDEF0123456789"));
+    in(Event::READ); // budget runs out
+    REQUIRE(in.size() == 20);
+    REQUIRE(renotified == 1);
+    in(Event::READ); // less than requested; drained
+    REQUIRE(in.size() == 26);
+    REQUIRE(renotified == 1);
+    in.applyData(cnv("0123456789ABCDEF0123456789"));
+    in.setDrainBudget(64, 2, [&renotified]() { renotified++; });
+    in(Event::READ); // iterations run out
+    REQUIRE(in.size() == 42);
+    REQUIRE(renotified == 2);
+    in(Event::READ);
+    REQUIRE(in.size() == 52);
+    REQUIRE(renotified == 2);
+    in.applyData(cnv("01234567"));
+    in(Event::READ); // EOF after data is left for the next event
+    REQUIRE(in.size() == 60);
+    REQUIRE(renotified == 3);
+    REQUIRE(in.lastError() == 0);
+    REQUIRE(in.running());
+
+    REQUIRE(callog == std::vector<intptr_t>({
+                          // clang-format off
+        RECEIVER, 8, 8,
+        RECEIVER, 8, 8,
+        RECEIVER, 4, 4,
+        RECEIVER, 8, 6,
+        RECEIVER, 8, 8,
+        RECEIVER, 8, 8,
+        RECEIVER, 8, 8,
+        RECEIVER, 8, 2,
+        RECEIVER, 8, 8,
+        RECEIVER, 4, 0,
+                          // clang-format on
+                      }));
+}
@@ -0,0 +1,82 @@
+#include <set>
+#include <mutex>
+#include <thread>
+#include <stdexcept>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <squall/core/LoopGroup.hxx>
+#include <squall/core/Sockets.hxx>
+#include "../catch.hpp"
+
+using squall::core::LoopGroup;
+using squall::core::PlatformLoop;
+using squall::core::listenSocket;
+using squall::core::reusePortSupported;
+
+
+TEST_CASE("Unittest squall::core::LoopGroup", "[loops]") {
+    auto sp_group = LoopGroup::createShared(3);
+    REQUIRE(sp_group->size() == 3);
+    REQUIRE(!sp_group->running());
+    REQUIRE(sp_group->loop(0) != sp_group->loop(1));
+
+    std::mutex mutex;
+    std::set<std::thread::id> threads;
+    std::vector<int> done(3, 0);
+    std::vector<std::shared_ptr<int>> states;
+
+    sp_group->start([&](size_t index, const std::shared_ptr<PlatformLoop>& sp_loop) {
+        std::lock_guard<std::mutex> lock(mutex);
+        threads.insert(std::this_thread::get_id());
+        auto sp_state = std::make_shared<int>(int(index));
+        states.push_back(sp_state);
+        return sp_state;
+    });
+    REQUIRE(sp_group->running());
+    REQUIRE_THROWS(sp_group->start(nullptr));
+
+    for (size_t index = 0; index < 3; index++)
+        for (int i = 0; i < 100; i++)
+            sp_group->post(index, [&done, index]() { done[index]++; }); // each counter is touched by one loop
+    sp_group->stop();
+    sp_group->join();
+    REQUIRE(!sp_group->running());
+
+    REQUIRE(threads.size() == 3);
+    REQUIRE(threads.count(std::this_thread::get_id()) == 0);
+    REQUIRE(done == std::vector<int>({100, 100, 100}));
+    REQUIRE(states.size() == 3);
+    for (auto& sp_state : states)
+        REQUIRE(sp_state.use_count() == 1); // released by loop threads
+}
+
+
+TEST_CASE("Unittest squall::core::LoopGroup; worker error", "[loops]") {
+    auto sp_group = LoopGroup::createShared(2, false);
+    sp_group->start([](size_t index, const std::shared_ptr<PlatformLoop>& sp_loop) -> std::shared_ptr<void> {
+        if (index == 1)
+            throw std::runtime_error("worker failed");
+        return nullptr;
+    });
+    sp_group->stop();
+    REQUIRE_THROWS_AS(sp_group->join(), std::runtime_error&);
+}
+
+
+TEST_CASE("Unittest squall::core::listenSocket", "[loops]") {
+    int a = listenSocket("127.0.0.1", 0);
+    struct sockaddr_in addr;
+    socklen_t length = sizeof(addr);
+    REQUIRE(getsockname(a, reinterpret_cast<struct sockaddr*>(&addr), &length) == 0);
+    auto port = ntohs(addr.sin_port);
+    REQUIRE(port > 0);
+
+    if (reusePortSupported()) {
+        int b = listenSocket("127.0.0.1", port); // the same port for the next loop
+        REQUIRE(b >= 0);
+        close(b);
+    }
+    REQUIRE_THROWS_AS(listenSocket("127.0.0.1", port, false), squall::exc::CannotListen&);
+    close(a);
+}
@@ -1,3 +1,4 @@
+#include <array>
 #include <string>
 #include <memory>
 #include <iostream>
@@ -270,3 +271,200 @@ TEST_CASE("Unittest squall::core::OutcommingBuffer", "[buffers]") {
                           // clang-format on
                       }));
 }
+
+
+TEST_CASE("Unittest squall::core::OutcommingBuffer write overloads", "[buffers]") {
+    std::vector<intptr_t> callog;
+
+    OutcomingBufferTest out(callog, [](bool) { return true; }, 8, 16);
+
+    REQUIRE(out.write("0123", 4) == 4);
+    REQUIRE(out.write(std::string("4567")) == 4);
+    REQUIRE(out.write({'8', '9'}) == 2);
+    auto space = out.prepare(100);
+    REQUIRE(space.second == 6);
+    std::memcpy(space.first, "ABCD", 4);
+    out.commit(4);
+    REQUIRE(out.size() == 14);
+    REQUIRE(out.write("EFGH", 4) == 2);
+    REQUIRE(out.size() == 16);
+    REQUIRE(out.prepare(100).second == 0);
+    out(Event::WRITE);
+    out(Event::WRITE);
+    REQUIRE(out.size() == 0);
+    REQUIRE(out.write(cnv("89")) == 2);
+    REQUIRE(callog == std::vector<intptr_t>({TRANSMITER, 8, 8, TRANSMITER, 8, 8}));
+}
+
+
+TEST_CASE("Unittest squall::core::OutcommingBuffer write-through mode", "[buffers]") {
+    std::vector<intptr_t> callog;
+
+    auto flow_ctrl = [&callog](bool resume) {
+        callog.push_back(resume ? RESUME : PAUSE);
+        return true;
+    };
+
+    OutcomingBufferTest out(callog, flow_ctrl, 8, 16);
+    out(Event::WRITE); // nothing to send; pause
+    REQUIRE(!out.running());
+    REQUIRE(!out.writeThrough());
+    out.setWriteThrough(true);
+    REQUIRE(out.writeThrough());
+
+    callog.push_back(MARK);
+    callog.push_back(1000);
+    REQUIRE(out.write("0123", 4) == 4); // sent at once; flow is not resumed
+    REQUIRE(out.size() == 0);
+    REQUIRE(!out.running());
+    auto space = out.prepare(4);
+    std::memcpy(space.first, "4567", 4);
+    out.commit(4);
+    REQUIRE(out.size() == 0);
+    REQUIRE(!out.running());
+
+    callog.push_back(MARK);
+    callog.push_back(2000);
+    out.setApplySize(6);
+    REQUIRE(out.write("0123456789", 10) == 10); // unsent tail is buffered
+    REQUIRE(out.size() == 4);
+    REQUIRE(out.running());
+    REQUIRE(out.write("ABCD", 4) == 4);  // buffer is not empty; no write-through
+    REQUIRE(out.size() == 8);
+    out(Event::WRITE);
+    out(Event::WRITE);
+    REQUIRE(out.size() == 0);
+    REQUIRE(!out.running());
+
+    callog.push_back(MARK);
+    callog.push_back(3000);
+    out.setBufferError(13);
+    REQUIRE(out.write("0123", 4) == 4); // transmiter failed; data is buffered
+    REQUIRE(out.size() == 4);
+    REQUIRE(out.running());
+
+    REQUIRE(callog == std::vector<intptr_t>({
+                          // clang-format off
+        RESUME,
+        PAUSE,
+        MARK, 1000,
+        TRANSMITER, 4, 4,
+        TRANSMITER, 4, 4,
+        MARK, 2000,
+        TRANSMITER, 10, 6,
+        RESUME,
+        TRANSMITER, 8, 6,
+        TRANSMITER, 2, 2,
+        PAUSE,
+        MARK, 3000,
+        TRANSMITER_ERR, 4, 13,
+        RESUME,
+                          // clang-format on
+                      }));
+}
+
+
+TEST_CASE("Unittest squall::core::OutcommingBuffer handler replaced inside itself", "[buffers]") {
+    std::vector<intptr_t> callog;
+
+    auto flow_ctrl = [&callog](bool resume) {
+        callog.push_back(resume ? RESUME : PAUSE);
+        return true;
+    };
+
+    OutcomingBufferTest out(callog, flow_ctrl, 8, 16);
+    std::array<char, 64> heavy;
+    heavy.fill('x');
+    auto marker = std::make_shared<int>(0);
+
+    auto second = [&callog, &out, heavy, marker](int revents, void* payload) {
+        out.cancel(); // destroys nothing until return
+        callog.push_back(HANDLER);
+        callog.push_back(heavy[63]);
+        callog.push_back(marker.use_count());
+    };
+    auto first = [&callog, &out, &second, heavy, marker](int revents, void* payload) {
+        out.setup(second, 4); // replaces running handler
+        callog.push_back(HANDLER);
+        callog.push_back(heavy[0]);
+        callog.push_back(marker.use_count());
+    };
+
+    out.setup(first, 4);
+    REQUIRE(marker.use_count() == 4);
+    out.write("0123", 4);
+    out(Event::WRITE);
+    REQUIRE(marker.use_count() == 4); // the first handler is released after call, the second is held
+    out.write("4567", 4);
+    out(Event::WRITE);
+    REQUIRE(marker.use_count() == 3); // the second handler is released after call
+    out.write("89AB", 4);
+    out(Event::WRITE);
+
+    REQUIRE(callog == std::vector<intptr_t>({
+                          // clang-format off
+        RESUME,
+        TRANSMITER, 4, 4,
+        PAUSE,
+        HANDLER, 'x', 5,
+        RESUME,
+        TRANSMITER, 4, 4,
+        PAUSE,
+        HANDLER, 'x', 4,
+        RESUME,
+        TRANSMITER, 4, 4,
+        PAUSE,
+                          // clang-format on
+                      }));
+}
+
+
+TEST_CASE("Unittest squall::core::EventHandler replaced from nested calls", "[buffers]") {
+    using squall::core::OnEvent;
+    squall::core::EventHandler handler;
+    auto marker = std::make_shared<int>(0);
+    int depth = 0;
+
+    std::function<OnEvent()> make = [&]() -> OnEvent {
+        return [&, marker](int revents, void* payload) {
+            if (++depth < 5) {
+                handler = make(); // replaces handler being called
+                handler(revents, payload);
+            } else
+                REQUIRE(marker.use_count() == 6); // replaced handlers live until their calls return
+        };
+    };
+
+    handler = make();
+    handler(Event::WRITE, nullptr);
+    REQUIRE(depth == 5);
+    REQUIRE(marker.use_count() == 2);
+    REQUIRE(handler);
+
+    handler = [&handler, marker](int revents, void* payload) {
+        handler = nullptr;
+        REQUIRE(!handler);
+        REQUIRE(marker.use_count() == 2); // itself is alive until return
+    };
+    REQUIRE(marker.use_count() == 2);
+    handler(Event::WRITE, nullptr);
+    REQUIRE(!handler);
+    REQUIRE(marker.use_count() == 1);
+}
+
+
+TEST_CASE("Unittest squall::core::OutcommingBuffer destroyed by own handler", "[buffers]") {
+    std::vector<intptr_t> callog;
+    auto marker = std::make_shared<int>(0);
+
+    std::unique_ptr<OutcomingBufferTest> up_out(new OutcomingBufferTest(callog, [](bool) { return true; }, 8, 16));
+    up_out->setup([&up_out, marker](int revents, void* payload) {
+        if (revents & Event::ERROR)
+            up_out.reset(); // the usual close on error
+    }, 4);
+    up_out->write("0123456789", 10);
+    up_out->setBufferError(13);
+    (*up_out)(Event::WRITE);
+    REQUIRE(!up_out);
+    REQUIRE(marker.use_count() == 1);
+}
@@ -0,0 +1,115 @@
+#include <chrono>
+#include <stdexcept>
+#include <unistd.h>
+#include <squall/core/Exceptions.hxx>
+#include <squall/core/PlatformLoop.hxx>
+#include <squall/core/PlatformWatchers.hxx>
+#include "../catch.hpp"
+
+using squall::core::Event;
+using squall::core::Backend;
+using squall::core::IoWatcher;
+using squall::core::PlatformLoop;
+using squall::core::TimerWatcher;
+
+
+TEST_CASE("Unittest squall::core::PlatformLoop", "[loops]") {
+    auto sp_loop = PlatformLoop::createShared();
+    sp_loop->start(); // nothing is watched
+    REQUIRE(!sp_loop->running());
+
+    int calls = 0;
+    TimerWatcher timer([&](int revents, void* payload) {
+        REQUIRE(sp_loop->running());
+        if (++calls == 3)
+            sp_loop->stop();
+    }, sp_loop);
+    REQUIRE(timer.setup(0.001, 0.001));
+    sp_loop->start();
+    REQUIRE(calls == 3);
+    REQUIRE(!sp_loop->running());
+    REQUIRE(timer.running());
+}
+
+
+TEST_CASE("Bounded run of squall::core::PlatformLoop", "[loops]") {
+    auto sp_loop = PlatformLoop::createShared();
+    REQUIRE(sp_loop->runIterations(5) == 1); // nothing is watched
+
+    int calls = 0;
+    TimerWatcher timer([&](int revents, void* payload) {
+        if (++calls == 5)
+            sp_loop->stop();
+    }, sp_loop);
+    REQUIRE(timer.setup(0.001, 0.001));
+
+    auto iterations = sp_loop->iterations();
+    REQUIRE(sp_loop->runIterations(3) == 3);
+    REQUIRE(sp_loop->iterations() == iterations + 3);
+    REQUIRE(calls <= 3);
+    while (calls < 5)
+        sp_loop->runIterations(100); // stopped at the fifth call
+    REQUIRE(!sp_loop->running());
+
+    calls = 0;
+    sp_loop->runFor(std::chrono::seconds(10));
+    REQUIRE(calls == 5); // stopped before deadline
+
+    REQUIRE(timer.setup(0.01, 0.01));
+    calls = 0;
+    auto started = std::chrono::steady_clock::now();
+    sp_loop->runFor(std::chrono::milliseconds(35));
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - started;
+    REQUIRE(elapsed.count() >= 0.035);
+    REQUIRE(calls >= 2);
+    REQUIRE(calls < 5);
+
+    timer.cancel();
+    started = std::chrono::steady_clock::now();
+    sp_loop->runFor(std::chrono::seconds(10)); // deadline alone does not keep loop running
+    elapsed = std::chrono::steady_clock::now() - started;
+    REQUIRE(elapsed.count() < 1);
+
+    TimerWatcher failing([&](int revents, void* payload) { throw std::runtime_error("handler"); }, sp_loop);
+    REQUIRE(failing.setup(0.001, 0.));
+    REQUIRE_THROWS_AS(sp_loop->runFor(std::chrono::seconds(10)), std::runtime_error&);
+    REQUIRE(!sp_loop->running());
+    started = std::chrono::steady_clock::now();
+    sp_loop->runFor(std::chrono::seconds(10)); // deadline of failed run is stopped
+    elapsed = std::chrono::steady_clock::now() - started;
+    REQUIRE(elapsed.count() < 1);
+}
+
+
+TEST_CASE("Options of squall::core::PlatformLoop", "[loops]") {
+    REQUIRE(PlatformLoop::supported(Backend::AUTO));
+    REQUIRE(PlatformLoop::supported(Backend::SELECT));
+    REQUIRE(PlatformLoop::createShared()->backend() != Backend::AUTO);
+
+    PlatformLoop::Options options;
+    options.backend = Backend::POLL;
+    auto sp_loop = PlatformLoop::createShared(options);
+    REQUIRE(sp_loop->backend() == Backend::POLL);
+
+    options.backend = Backend::PORT; // Solaris only
+    if (!PlatformLoop::supported(options.backend))
+        REQUIRE_THROWS_AS(PlatformLoop::createShared(options), squall::exc::CannotSetupWatching&);
+
+    int fds[2];
+    REQUIRE(pipe(fds) == 0);
+    int calls = 0;
+    auto run = [&](const std::shared_ptr<PlatformLoop>& sp_loop) {
+        IoWatcher watcher([&](int revents, void* payload) { calls++; }, sp_loop);
+        watcher.setup(fds[1], int(Event::WRITE));
+        calls = 0;
+        sp_loop->runFor(std::chrono::milliseconds(50));
+        return calls;
+    };
+    options = PlatformLoop::Options();
+    options.io_collect_interval = 0.01;
+    options.signalfd = true;
+    auto collected = run(PlatformLoop::createShared(options));
+    REQUIRE(collected * 10 < run(PlatformLoop::createShared())); // loop sleeps to collect events
+    close(fds[0]);
+    close(fds[1]);
+}
@@ -0,0 +1,50 @@
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <squall/core/Search.hxx>
+#include "../catch.hpp"
+
+using squall::core::SearchFunc;
+using squall::core::searchBytes;
+using squall::core::searchScalar;
+
+
+/* Checks search function against std::search on all suffixes of `haystack`. */
+inline bool verify(SearchFunc search, const std::string& haystack, const std::string& needle) {
+    for (size_t from = 0; from <= haystack.size(); from++) {
+        auto begin = haystack.data() + from, end = haystack.data() + haystack.size();
+        auto expected = std::search(begin, end, needle.begin(), needle.end());
+        if (search(begin, end, needle.data(), needle.size()) != expected)
+            return false;
+    }
+    return true;
+}
+
+
+TEST_CASE("Unittest squall::core::searchBytes", "[search]") {
+
+    std::vector<SearchFunc> functions = {searchScalar, searchBytes};
+#if defined(SQUALL_SEARCH_X86) && defined(__SSE2__)
+    functions.push_back(squall::core::searchSSE2);
+#endif
+#if defined(SQUALL_SEARCH_X86)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+        functions.push_back(squall::core::searchAVX2);
+#endif
+
+    std::string haystack;
+    for (int i = 0; i < 200; i++)
+        haystack += (i % 7 == 0) ? "\r" : (i % 11 == 0) ? "\n" : std::string(1, char('a' + i % 26));
+    haystack += "\r\n\r\n";
+
+    for (auto search : functions) {
+        REQUIRE(verify(search, haystack, "\n"));
+        REQUIRE(verify(search, haystack, "\r\n"));
+        REQUIRE(verify(search, haystack, "\r\n\r"));
+        REQUIRE(verify(search, haystack, "\r\n\r\n"));
+        REQUIRE(verify(search, haystack, "xyz"));
+        REQUIRE(verify(search, "", "\r\n"));
+        REQUIRE(verify(search, "\r", "\r\n"));
+    }
+}
@@ -0,0 +1,150 @@
+#include <string>
+#include <memory>
+#include <squall/core/Buffers.hxx>
+#include "../catch.hpp"
+
+using squall::core::Event;
+using squall::core::SegmentedOutcomingBuffer;
+using std::placeholders::_1;
+using std::placeholders::_2;
+
+
+enum : intptr_t { MARK = -1, HANDLER = -2, TRANSMITER = -3, TRANSMITER_ERR = -4, RESUME = -5, PAUSE = -6 };
+
+
+class SegmentedOutcomingBufferTest : public SegmentedOutcomingBuffer {
+    int buffer_error;
+    size_t apply_size;
+    std::vector<intptr_t>& callog_;
+
+    std::pair<size_t, int> transmiter(const struct iovec* iov, int iovcnt) {
+        if (buffer_error == 0) {
+            callog_.push_back(TRANSMITER);
+            callog_.push_back(iovcnt);
+            size_t transmited = 0;
+            for (int i = 0; (i < iovcnt) && (transmited < apply_size); i++) {
+                auto number = iov[i].iov_len < apply_size - transmited ? iov[i].iov_len : apply_size - transmited;
+                output.append(static_cast<const char*>(iov[i].iov_base), number);
+                transmited += number;
+            }
+            callog_.push_back(transmited);
+            return std::make_pair(transmited, 0);
+        } else {
+            callog_.push_back(TRANSMITER_ERR);
+            callog_.push_back(iovcnt);
+            callog_.push_back(buffer_error);
+            return std::make_pair(0, buffer_error);
+        }
+    }
+
+  public:
+    std::string output;
+
+    /* Constructor */
+    SegmentedOutcomingBufferTest(std::vector<intptr_t>& callog, FlowCtrl&& flow_ctrl, size_t block_size,
+                                 size_t max_size)
+        : SegmentedOutcomingBuffer(std::bind(&SegmentedOutcomingBufferTest::transmiter, this, _1, _2),
+                                   std::forward<FlowCtrl>(flow_ctrl), block_size, max_size),
+          buffer_error(0), apply_size(max_size), callog_(callog) {}
+
+    void setBufferError(int value) {
+        buffer_error = value;
+    }
+
+    void setApplySize(size_t value) {
+        apply_size = value;
+    }
+
+    using SegmentedOutcomingBuffer::operator();
+};
+
+
+TEST_CASE("Unittest squall::core::SegmentedOutcomingBuffer", "[buffers]") {
+    std::vector<intptr_t> callog;
+
+    auto flow_ctrl = [&callog](bool resume) {
+        callog.push_back(resume ? RESUME : PAUSE);
+        return true;
+    };
+
+    SegmentedOutcomingBufferTest out(callog, flow_ctrl, 8, 64);
+
+    auto handler = [&callog](int revents, void* payload) {
+        auto p_buff = static_cast<SegmentedOutcomingBufferTest*>(payload);
+        callog.push_back(HANDLER);
+        callog.push_back(revents);
+        callog.push_back(p_buff->size());
+        callog.push_back(p_buff->lastError());
+    };
+
+    callog.push_back(MARK);
+    callog.push_back(1000);
+    REQUIRE(out.running());
+    REQUIRE(out.write(std::string("HEAD")) == 4);
+    REQUIRE(out.write(":", 1) == 1);             // coalesced with previous write
+    REQUIRE(out.segments() == 1);
+    std::vector<char> body(16, 'B');
+    REQUIRE(out.write(std::move(body)) == 16);   // moved, not copied
+    REQUIRE(out.segments() == 2);
+    std::shared_ptr<const char> trailer(new char[3]{'T', 'R', 'L'}, std::default_delete<const char[]>());
+    REQUIRE(out.write(trailer, 3) == 3);         // refcounted
+    REQUIRE(trailer.use_count() == 2);
+    REQUIRE(out.write({'S', 'S'}) == 2);         // small, copied
+    REQUIRE(out.segments() == 4);
+    REQUIRE(out.size() == 26);
+    out.setApplySize(10);
+    out(Event::WRITE);
+    REQUIRE(out.size() == 16);
+    REQUIRE(out.segments() == 3);
+    out.setApplySize(64);
+    out(Event::WRITE);
+    REQUIRE(out.size() == 0);
+    REQUIRE(out.segments() == 0);
+    REQUIRE(trailer.use_count() == 1);
+    REQUIRE(out.output == "HEAD:BBBBBBBBBBBBBBBBTRLSS");
+
+    callog.push_back(MARK);
+    callog.push_back(2000);
+    REQUIRE(out.setup(handler, 0) == 1); // early result (buffer size <= 0)
+    REQUIRE(out.write(std::string(60, 'X')) == 60);
+    REQUIRE(out.write(std::string(10, 'Y')) == 4);
+    REQUIRE(out.size() == 64);
+    out.setApplySize(60);
+    out(Event::WRITE);
+    out(Event::WRITE); // event!
+
+    callog.push_back(MARK);
+    callog.push_back(3000);
+    REQUIRE(out.write("Z", 1) == 1);
+    REQUIRE(out.setup(handler, 0) == 0); // await flushing (buffer size > 0)
+    out.setBufferError(13);
+    out(Event::WRITE);
+    REQUIRE(!out.active());
+    REQUIRE(!out.running());
+    REQUIRE(out.size() == 1);
+    out.cleanup();
+    REQUIRE(out.size() == 0);
+
+    REQUIRE(callog == std::vector<intptr_t>({
+                          // clang-format off
+        RESUME,
+        MARK, 1000,
+        TRANSMITER, 4, 10,
+        TRANSMITER, 3, 16,
+        PAUSE,
+
+        MARK, 2000,
+        RESUME,
+        TRANSMITER, 2, 60,
+        TRANSMITER, 1, 4,
+        PAUSE,
+        HANDLER, Event::BUFFER|Event::WRITE, 0, 0,
+
+        MARK, 3000,
+        RESUME,
+        TRANSMITER_ERR, 1, 13,
+        PAUSE,
+        HANDLER, Event::BUFFER|Event::ERROR, 1, 13,
+                          // clang-format on
+                      }));
+}
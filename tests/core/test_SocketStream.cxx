@@ -0,0 +1,93 @@
+#ifdef HAVE_UNISTD_H
+#include <chrono>
+#include <string>
+#include <memory>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <squall/core/SocketStream.hxx>
+#include <squall/core/PlatformLoop.hxx>
+#include "../catch.hpp"
+
+using squall::core::Event;
+using squall::core::PlatformLoop;
+using squall::core::SocketStream;
+using squall::core::IncomingBuffer;
+using squall::core::OutcomingBuffer;
+
+
+TEST_CASE("Unittest squall::core::SocketStream", "[stream]") {
+    int fds[2];
+    REQUIRE(socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+    fcntl(fds[0], F_SETFL, fcntl(fds[0], F_GETFL) | O_NONBLOCK);
+    int peer = fds[1];
+    auto sp_loop = PlatformLoop::createShared();
+
+    std::unique_ptr<SocketStream> up_stream(new SocketStream(fds[0], sp_loop, 8, 64));
+    REQUIRE(up_stream->fd() == fds[0]);
+    REQUIRE(up_stream->mode() == Event::READ); // WRITE is not armed while nothing is to send
+    REQUIRE(up_stream->updates() == 1);
+
+    // data written to empty buffer is sent at once
+    REQUIRE(up_stream->outcoming().write(std::string("ping\n")) == 5);
+    REQUIRE(up_stream->outcoming().size() == 0);
+    REQUIRE(up_stream->mode() == Event::READ);
+    char buff[16];
+    REQUIRE(read(peer, buff, sizeof(buff)) == 5);
+
+    std::vector<std::string> lines;
+    std::vector<int> events;
+    up_stream->incoming().setup([&](int revents, void* payload) {
+        events.push_back(revents);
+        auto p_buffer = static_cast<IncomingBuffer*>(payload);
+        if (revents == (Event::BUFFER | Event::READ)) {
+            while (p_buffer->lastResult() > 0) {
+                auto line = p_buffer->read(p_buffer->lastResult());
+                lines.emplace_back(line.begin(), line.end());
+                up_stream->outcoming().write(line.data(), line.size()); // echo
+            }
+            if (lines.size() == 2)
+                sp_loop->stop();
+        } else if (revents & Event::ERROR) {
+            REQUIRE(p_buffer->lastError() == 0); // EOF
+            up_stream.reset(); // destroyed by own handler
+            sp_loop->stop();
+        }
+    }, std::vector<char>{'\n'}, 64);
+
+    REQUIRE(write(peer, "hello\nworld\n", 12) == 12);
+    sp_loop->start();
+    REQUIRE(lines == (std::vector<std::string>{"hello\n", "world\n"}));
+    REQUIRE(read(peer, buff, sizeof(buff)) == 12);
+    REQUIRE(up_stream->mode() == Event::READ);
+
+    // the rest of data which socket does not accept arms WRITE until it is sent
+    int size = 4096;
+    REQUIRE(setsockopt(fds[0], SOL_SOCKET, SO_SNDBUF, &size, sizeof(size)) == 0);
+    std::vector<char> chunk(64, 'x');
+    size_t written = 0;
+    while (up_stream->outcoming().size() == 0)
+        written += up_stream->outcoming().write(chunk);
+    REQUIRE(up_stream->mode() == (Event::READ | Event::WRITE));
+    auto updates = up_stream->updates();
+    fcntl(peer, F_SETFL, fcntl(peer, F_GETFL) | O_NONBLOCK);
+    size_t drained = 0;
+    while (drained < written) {
+        ssize_t received;
+        while ((received = read(peer, buff, sizeof(buff))) > 0)
+            drained += received;
+        sp_loop->runFor(std::chrono::milliseconds(1));
+    }
+    REQUIRE(drained == written);
+    REQUIRE(up_stream->outcoming().size() == 0);
+    REQUIRE(up_stream->mode() == Event::READ);
+    REQUIRE(up_stream->updates() == updates + 1);
+
+    close(peer);
+    sp_loop->start();
+    REQUIRE(events.back() == (Event::BUFFER | Event::ERROR));
+    REQUIRE(!up_stream);
+    REQUIRE(fcntl(fds[0], F_GETFD) == -1); // socket is closed
+}
+#endif // HAVE_UNISTD_H
@@ -0,0 +1,67 @@
+#include <thread>
+#include <vector>
+#include <squall/core/TaskQueue.hxx>
+#include "../catch.hpp"
+
+using squall::core::PlatformLoop;
+using squall::core::TaskQueue;
+
+
+TEST_CASE("Unittest squall::core::TaskQueue; coalesced wakeups", "[tasks]") {
+    auto sp_loop = PlatformLoop::createShared();
+    auto sp_queue = TaskQueue::createShared(sp_loop);
+    size_t done = 0;
+
+    std::thread producer([&sp_queue, &done]() {
+        for (int i = 0; i < 10000; i++)
+            sp_queue->post([&done]() { done++; });
+    });
+    producer.join();
+    sp_queue->post([&sp_loop]() { sp_loop->stop(); });
+
+    sp_loop->start();
+    REQUIRE(done == 10000);
+    REQUIRE(sp_queue->wakeups() == 1);
+}
+
+
+TEST_CASE("Unittest squall::core::TaskQueue; concurrent producers", "[tasks]") {
+    const int PRODUCERS = 4;
+    const int TASKS = 20000;
+    auto sp_loop = PlatformLoop::createShared();
+    auto sp_queue = TaskQueue::createShared(sp_loop, 64);
+    std::vector<int> last(PRODUCERS, -1);
+    bool ordered = true;
+    int done = 0;
+
+    std::vector<std::thread> producers;
+    for (int p = 0; p < PRODUCERS; p++)
+        producers.emplace_back([&, p]() {
+            for (int i = 0; i < TASKS; i++)
+                sp_queue->post([&, p, i]() {
+                    ordered = ordered && (last[p] == i - 1); // FIFO per producer
+                    last[p] = i;
+                    if (++done == PRODUCERS * TASKS)
+                        sp_loop->stop();
+                });
+        });
+
+    sp_loop->start();
+    for (auto& producer : producers)
+        producer.join();
+    REQUIRE(done == PRODUCERS * TASKS);
+    REQUIRE(ordered);
+    REQUIRE(sp_queue->wakeups() >= (PRODUCERS * TASKS) / 64); // batch limit
+}
+
+
+TEST_CASE("Unittest squall::core::TaskQueue; drops not run tasks", "[tasks]") {
+    auto sp_loop = PlatformLoop::createShared();
+    auto sp_marker = std::make_shared<int>(0);
+    {
+        auto sp_queue = TaskQueue::createShared(sp_loop);
+        sp_queue->post([sp_marker]() {});
+        REQUIRE(sp_marker.use_count() == 2);
+    }
+    REQUIRE(sp_marker.use_count() == 1);
+}
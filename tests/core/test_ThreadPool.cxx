@@ -0,0 +1,90 @@
+#include <atomic>
+#include <string>
+#include <thread>
+#include <stdexcept>
+#include <squall/core/Offload.hxx>
+#include <squall/core/ThreadPool.hxx>
+#include "../catch.hpp"
+
+using squall::core::Event;
+using squall::core::Offload;
+using squall::core::PlatformLoop;
+using squall::core::ThreadPool;
+
+
+TEST_CASE("Unittest squall::core::ThreadPool", "[tasks]") {
+    std::atomic<int> done(0);
+    {
+        auto sp_pool = ThreadPool::createShared(3);
+        REQUIRE(sp_pool->size() == 3);
+        for (int i = 0; i < 1000; i++)
+            sp_pool->submit([&done, &sp_pool]() {
+                done++;
+                sp_pool->submit([&done]() { done++; }); // goes to own deque
+            });
+        sp_pool->submit([]() { throw std::runtime_error("swallowed"); });
+        sp_pool->shutdown(); // runs all submitted tasks
+        REQUIRE(done == 2000);
+        REQUIRE_THROWS(sp_pool->submit([]() {}));
+    }
+    REQUIRE(done == 2000);
+}
+
+
+TEST_CASE("Unittest squall::core::Offload", "[tasks]") {
+    auto sp_loop = PlatformLoop::createShared();
+    auto sp_pool = ThreadPool::createShared(2);
+    auto loop_thread = std::this_thread::get_id();
+    std::string result;
+    std::vector<long> sums(3, 0);
+
+    Offload<int> offload(
+        [&](int ctx, int revents, void* payload) {
+            REQUIRE(std::this_thread::get_id() == loop_thread);
+            if (revents == Event::ASYNC)
+                result += std::to_string(ctx);
+            else if (revents == (Event::ASYNC | Event::ERROR)) {
+                auto p_error = static_cast<std::exception_ptr*>(payload);
+                try {
+                    std::rethrow_exception(*p_error);
+                } catch (const std::runtime_error& error) {
+                    result += error.what();
+                }
+            }
+            if (offload.pending() == 0)
+                sp_loop->stop();
+        },
+        sp_loop, sp_pool);
+
+    for (int ctx = 0; ctx < 3; ctx++)
+        offload.submit(ctx, [&sums, ctx]() {
+            for (long i = 0; i < 100000; i++)
+                sums[ctx] += i;
+        });
+    offload.submit(9, []() { throw std::runtime_error("E"); });
+    REQUIRE(offload.pending() == 4);
+    sp_loop->start();
+
+    REQUIRE(offload.pending() == 0);
+    REQUIRE(result.size() == 4);
+    REQUIRE(result.find('E') != std::string::npos);
+    REQUIRE(sums == std::vector<long>({4999950000, 4999950000, 4999950000}));
+}
+
+
+TEST_CASE("Unittest squall::core::Offload; destroyed with work in flight", "[tasks]") {
+    auto sp_loop = PlatformLoop::createShared();
+    auto sp_pool = ThreadPool::createShared(1);
+    std::atomic<bool> release(false);
+    int called = 0;
+    {
+        Offload<int> offload([&called](int ctx, int revents, void* payload) { called++; }, sp_loop, sp_pool);
+        offload.submit(1, [&release]() {
+            while (!release)
+                std::this_thread::yield();
+        });
+    }
+    release = true;
+    sp_pool->shutdown();
+    REQUIRE(called == 0);
+}
@@ -0,0 +1,89 @@
+#include <chrono>
+#include <vector>
+#include <memory>
+#include <squall/core/TimingWheel.hxx>
+#include "../catch.hpp"
+
+using squall::core::PlatformLoop;
+using squall::core::TimingWheel;
+
+
+/* Timeout which logs its `id` and stops loop after `last` one. */
+struct LoggedTimeout : TimingWheel::Node {
+    int id;
+    std::vector<int>& log;
+    PlatformLoop& loop;
+    bool last;
+
+    LoggedTimeout(int id, std::vector<int>& log, PlatformLoop& loop, bool last = false)
+        : TimingWheel::Node(LoggedTimeout::callback), id(id), log(log), loop(loop), last(last) {}
+
+    static void callback(TimingWheel::Node* p_node) {
+        auto p_timeout = static_cast<LoggedTimeout*>(p_node);
+        p_timeout->log.push_back(p_timeout->id);
+        if (p_timeout->last)
+            p_timeout->loop.stop();
+    }
+};
+
+
+TEST_CASE("Unittest squall::core::TimingWheel", "[timers]") {
+    std::vector<int> log;
+    auto sp_loop = PlatformLoop::createShared();
+    TimingWheel wheel(sp_loop, 0.001);
+    REQUIRE(wheel.resolution() == 0.001);
+
+    LoggedTimeout a(1, log, *sp_loop), b(2, log, *sp_loop), c(3, log, *sp_loop), d(4, log, *sp_loop, true);
+    wheel.arm(&a, 0.030);
+    wheel.arm(&b, 0.010);
+    wheel.arm(&c, 0.020);
+    wheel.arm(&d, 0.300); // beyond the first level; cascaded down
+    REQUIRE(wheel.size() == 4);
+    REQUIRE(a.armed());
+
+    wheel.arm(&b, 0.040);        // re-armed
+    REQUIRE(wheel.cancel(&c));   // canceled
+    REQUIRE(!wheel.cancel(&c));
+    REQUIRE(wheel.size() == 3);
+
+    sp_loop->start();
+    REQUIRE(log == std::vector<int>({1, 2, 4}));
+    REQUIRE(wheel.size() == 0);
+    REQUIRE(!a.armed());
+
+    {
+        LoggedTimeout e(5, log, *sp_loop);
+        wheel.arm(&e, 0.010);
+        REQUIRE(wheel.size() == 1);
+    } // destroyed armed timeout is canceled
+    REQUIRE(wheel.size() == 0);
+
+    wheel.arm(&a, 1.0);
+    wheel.arm(&d, 0.001); // at least one tick
+    sp_loop->start();
+    REQUIRE(log == std::vector<int>({1, 2, 4, 4}));
+    wheel.clear();
+    REQUIRE(!a.armed());
+    REQUIRE(wheel.size() == 0);
+}
+
+
+TEST_CASE("squall::core::TimingWheel never expires early", "[timers]") {
+    std::vector<int> log;
+    auto sp_loop = PlatformLoop::createShared();
+    TimingWheel wheel(sp_loop, 0.01);
+
+    LoggedTimeout keeper(0, log, *sp_loop);
+    wheel.arm(&keeper, 10.0); // keeps ticker phase while timeouts are armed in the middle of ticks
+    for (int i = 1; i <= 5; i++) {
+        sp_loop->runFor(std::chrono::milliseconds(3));
+        LoggedTimeout timeout(i, log, *sp_loop, true);
+        auto started = std::chrono::steady_clock::now();
+        wheel.arm(&timeout, 0.01);
+        sp_loop->start();
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - started;
+        REQUIRE(log.back() == i);
+        REQUIRE(elapsed.count() >= 0.01);
+        REQUIRE(elapsed.count() < 0.05);
+    }
+}
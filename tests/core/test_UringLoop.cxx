@@ -0,0 +1,96 @@
+#ifdef HAVE_IO_URING_H
+#include <string>
+#include <memory>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <squall/core/UringLoop.hxx>
+#include "../catch.hpp"
+
+using squall::core::Event;
+using squall::core::UringLoop;
+using squall::core::UringStream;
+
+
+TEST_CASE("Unittest squall::core::UringLoop", "[loops]") {
+    if (!UringLoop::supported()) {
+        WARN("io_uring is not available; skipped");
+        return;
+    }
+    int fds[2];
+    REQUIRE(socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+    auto sp_loop = UringLoop::createShared(8, 4, 16);
+    REQUIRE(!sp_loop->runOnce()); // nothing is in flight
+
+    std::string result;
+    int written = 0;
+    std::unique_ptr<UringStream> up_echo;
+    UringStream client([&](int revents, void* payload) {
+        if (revents == Event::WRITE) {
+            written++;
+        } else if (revents == Event::READ) {
+            auto p_chunk = static_cast<UringLoop::Chunk*>(payload);
+            result += std::string(p_chunk->data, p_chunk->size);
+            if (p_chunk->size == 0) {
+                result += "E";
+                sp_loop->stop();
+            } else if (result.size() == 6) {
+                up_echo.reset(); // destroyed with receive in flight
+                shutdown(fds[1], SHUT_WR);
+            }
+        }
+    }, sp_loop);
+
+    up_echo.reset(new UringStream([&](int revents, void* payload) {
+        if (revents == Event::READ) {
+            auto p_chunk = static_cast<UringLoop::Chunk*>(payload);
+            REQUIRE(up_echo->write(p_chunk->data, p_chunk->size));
+        }
+    }, sp_loop));
+
+    REQUIRE(!client.write("ABC", 3)); // not set up
+    REQUIRE(client.setup(fds[0]));
+    REQUIRE(up_echo->setup(fds[1]));
+    REQUIRE(client.running());
+    REQUIRE(client.write("ABC", 3));
+    REQUIRE(client.write("DEF", 3)); // sent after the first send is completed
+    REQUIRE(client.pending() == 6);
+    sp_loop->start();
+    REQUIRE(result == "ABCDEFE");
+    REQUIRE(written == 1); // written data is coalesced
+    REQUIRE(client.pending() == 0);
+    REQUIRE(!client.running()); // end of stream stops receiving
+    REQUIRE(!client.cancel());
+    close(fds[0]);
+    close(fds[1]);
+}
+
+
+TEST_CASE("Canceled squall::core::UringStream", "[loops]") {
+    if (!UringLoop::supported())
+        return;
+    int fds[2];
+    REQUIRE(socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+    auto sp_loop = UringLoop::createShared();
+
+    std::string result;
+    UringStream stream([&](int revents, void* payload) {
+        auto p_chunk = static_cast<UringLoop::Chunk*>(payload);
+        result += std::string(p_chunk->data, p_chunk->size);
+    }, sp_loop);
+    REQUIRE(stream.setup(fds[0]));
+    REQUIRE(stream.cancel());
+    REQUIRE(!stream.cancel());
+    while (sp_loop->runOnce(true)) {
+    }
+    REQUIRE(write(fds[1], "A", 1) == 1);
+    REQUIRE(!sp_loop->runOnce(true)); // nothing is in flight
+    REQUIRE(result == "");
+
+    REQUIRE(stream.setup(fds[0])); // data sent before is received now
+    REQUIRE(sp_loop->runOnce(true));
+    REQUIRE(result == "A");
+    REQUIRE(sp_loop->enters() > 0);
+    close(fds[0]);
+    close(fds[1]);
+}
+#endif // HAVE_IO_URING_H
@@ -0,0 +1,103 @@
+#include <set>
+#include <string>
+#include <squall/core/WatcherStorage.hxx>
+#include "../catch.hpp"
+
+using squall::core::ArenaStorage;
+using squall::core::FdStorage;
+using squall::core::HashStorage;
+
+
+/* Stored value which counts its living instances. */
+struct Counted {
+    int& alive;
+    int value;
+
+    Counted(int& alive, int value) : alive(alive), value(value) {
+        alive++;
+    }
+
+    ~Counted() {
+        alive--;
+    }
+};
+
+
+/* Common checks of watcher storage policy. */
+template <template <typename, typename> class Storage>
+void checkStorage() {
+    int alive = 0;
+    {
+        Storage<int, Counted> storage;
+        REQUIRE(storage.size() == 0);
+        REQUIRE(storage.find(1) == nullptr);
+        REQUIRE(!storage.erase(1));
+
+        std::vector<Counted*> pointers;
+        for (int i = 0; i < 1000; i++)
+            pointers.push_back(storage.emplace(i, alive, i * 10));
+        REQUIRE(storage.size() == 1000);
+        REQUIRE(alive == 1000);
+        for (int i = 0; i < 1000; i++) {
+            REQUIRE(storage.find(i) == pointers[i]); // stable addresses
+            REQUIRE(storage.find(i)->value == i * 10);
+        }
+        REQUIRE(storage.find(1000) == nullptr);
+
+        for (int i = 0; i < 1000; i += 2)
+            REQUIRE(storage.erase(i));
+        REQUIRE(storage.size() == 500);
+        REQUIRE(alive == 500);
+        for (int i = 0; i < 1000; i++) {
+            if (i % 2)
+                REQUIRE(storage.find(i) == pointers[i]);
+            else
+                REQUIRE(storage.find(i) == nullptr);
+        }
+
+        std::set<int> seen;
+        storage.forEach([&seen](const int& ctx) { seen.insert(ctx); });
+        REQUIRE(seen.size() == 500);
+        REQUIRE(*seen.begin() == 1);
+        REQUIRE(*seen.rbegin() == 999);
+
+        REQUIRE(storage.emplace(2, alive, -2)->value == -2);
+        REQUIRE(storage.find(2)->value == -2);
+        REQUIRE(storage.size() == 501);
+    }
+    REQUIRE(alive == 0);
+}
+
+
+TEST_CASE("Unittest squall::core::HashStorage", "[dispatcher]") {
+    checkStorage<HashStorage>();
+}
+
+
+TEST_CASE("Unittest squall::core::ArenaStorage", "[dispatcher]") {
+    checkStorage<ArenaStorage>();
+
+    int alive = 0;
+    ArenaStorage<std::string, Counted> storage;
+    auto p_a = storage.emplace("A", alive, 1);
+    storage.erase("A");
+    REQUIRE(storage.emplace("B", alive, 2) == p_a); // freed slot is reused
+    REQUIRE(storage.find("A") == nullptr);
+    REQUIRE(storage.find("B")->value == 2);
+}
+
+
+TEST_CASE("Unittest squall::core::FdStorage", "[dispatcher]") {
+    checkStorage<FdStorage>();
+
+    int alive = 0;
+    FdStorage<int, Counted> storage;
+    REQUIRE(storage.emplace(-1, alive, 0) == nullptr); // not a file descriptor
+    REQUIRE(storage.find(-1) == nullptr);
+    REQUIRE(!storage.erase(-1));
+    REQUIRE(storage.emplace(100000, alive, 1)->value == 1); // sparse descriptors
+    REQUIRE(storage.find(99999) == nullptr);
+    REQUIRE(storage.find(100000)->value == 1);
+    REQUIRE(storage.size() == 1);
+    REQUIRE(alive == 1);
+}